@@ -0,0 +1,49 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/AnalyzerStats.h"
+
+#include <map>
+#include <memory>
+
+#include "zeek/telemetry/Manager.h"
+
+namespace zeek::detail
+	{
+
+AnalyzerStatsScope* AnalyzerStatsScope::current = nullptr;
+
+AnalyzerStats* AnalyzerStats::Lookup(std::string_view kind, const std::string& name)
+	{
+	static std::map<std::pair<std::string, std::string>, std::unique_ptr<AnalyzerStats>> all;
+
+	auto key = std::make_pair(std::string(kind), name);
+
+	if ( auto it = all.find(key); it != all.end() )
+		return it->second.get();
+
+	static const int64_t bounds[] = {1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+	auto invocations = telemetry_mgr->CounterFamily(
+		"zeek", "analyzer-invocations", {"kind", "analyzer"},
+		"Number of times an analyzer was handed input", "1", true);
+	auto bytes = telemetry_mgr->CounterFamily("zeek", "analyzer-bytes", {"kind", "analyzer"},
+	                                          "Input bytes handed to an analyzer", "bytes", true);
+	auto cycles = telemetry_mgr->CounterFamily("zeek", "analyzer-cycles", {"kind", "analyzer"},
+	                                           "CPU cycles spent inside an analyzer", "cycles",
+	                                           true);
+	auto cycles_per_call = telemetry_mgr->HistogramFamily<int64_t>(
+		"zeek", "analyzer-cycles-per-call", {"kind", "analyzer"}, bounds,
+		"CPU cycles spent inside an analyzer per invocation", "cycles");
+
+	std::initializer_list<telemetry::LabelView> labels = {{"kind", kind}, {"analyzer", name}};
+
+	auto stats = std::unique_ptr<AnalyzerStats>(
+		new AnalyzerStats(invocations.GetOrAdd(labels), bytes.GetOrAdd(labels),
+	                      cycles.GetOrAdd(labels), cycles_per_call.GetOrAdd(labels)));
+
+	auto rval = stats.get();
+	all.emplace(std::move(key), std::move(stats));
+	return rval;
+	}
+
+	} // namespace zeek::detail
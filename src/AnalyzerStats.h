@@ -0,0 +1,112 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Optional per-analyzer accounting of CPU cycles, bytes, and invocations,
+// exported through the telemetry framework.  Enabled by the script-level
+// analyzer_profiling option.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "zeek/telemetry/Counter.h"
+#include "zeek/telemetry/Histogram.h"
+
+namespace zeek::detail
+	{
+
+// Returns a cheap, monotonically increasing timestamp.  This is the time
+// stamp counter where available and nanoseconds otherwise.
+inline uint64_t read_cycles()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+#endif
+	}
+
+// Metrics for one analyzer type.  Instances live until termination.
+class AnalyzerStats
+	{
+public:
+	// Returns the metrics for the analyzer of the given kind ("protocol"
+	// or "packet") and name, creating them on first use.
+	static AnalyzerStats* Lookup(std::string_view kind, const std::string& name);
+
+	void Record(uint64_t cycles, uint64_t bytes)
+		{
+		invocations.Inc();
+		this->bytes.Inc(bytes);
+		this->cycles.Inc(cycles);
+		cycles_per_call.Observe(cycles);
+		}
+
+private:
+	AnalyzerStats(telemetry::IntCounter invocations, telemetry::IntCounter bytes,
+	              telemetry::IntCounter cycles, telemetry::IntHistogram cycles_per_call)
+		: invocations(invocations), bytes(bytes), cycles(cycles), cycles_per_call(cycles_per_call)
+		{
+		}
+
+	telemetry::IntCounter invocations;
+	telemetry::IntCounter bytes;
+	telemetry::IntCounter cycles;
+	telemetry::IntHistogram cycles_per_call;
+	};
+
+// Accounts for the work done during its lifetime to an analyzer.  Scopes
+// nest as analyzers hand data to their children; each analyzer is only
+// charged with the cycles not spent in nested scopes.  A null stats
+// pointer makes this a no-op.
+class AnalyzerStatsScope
+	{
+public:
+	AnalyzerStatsScope(AnalyzerStats* arg_stats, uint64_t arg_bytes)
+		: stats(arg_stats), bytes(arg_bytes)
+		{
+		if ( ! stats )
+			return;
+
+		parent = current;
+		current = this;
+		start = read_cycles();
+		}
+
+	~AnalyzerStatsScope()
+		{
+		if ( ! stats )
+			return;
+
+		uint64_t total = read_cycles() - start;
+
+		current = parent;
+
+		if ( parent )
+			parent->child_cycles += total;
+
+		stats->Record(total > child_cycles ? total - child_cycles : 0, bytes);
+		}
+
+	AnalyzerStatsScope(const AnalyzerStatsScope&) = delete;
+	AnalyzerStatsScope& operator=(const AnalyzerStatsScope&) = delete;
+
+private:
+	static AnalyzerStatsScope* current;
+
+	AnalyzerStats* stats;
+	AnalyzerStatsScope* parent = nullptr;
+	uint64_t bytes;
+	uint64_t start = 0;
+	uint64_t child_cycles = 0;
+	};
+
+	} // namespace zeek::detail
@@ -40,6 +40,7 @@ const char* attr_name(AttrTag t)
 		"&deprecated",
 		"&is_assigned",
 		"&is_used",
+		"&fast_hash",
 	};
 
 	return attr_names[int(t)];
@@ -667,6 +668,11 @@ void Attributes::CheckAttr(Attr* a)
 			// FIXME: Check here for global ID?
 			break;
 
+		case ATTR_FAST_HASH:
+			if ( type->Tag() != TYPE_TABLE )
+				Error("&fast_hash only applicable to sets/tables");
+			break;
+
 		case ATTR_RAW_OUTPUT:
 			if ( type->Tag() != TYPE_FILE )
 				Error("&raw_output only applicable to files");
@@ -50,6 +50,7 @@ enum AttrTag
 	ATTR_DEPRECATED,
 	ATTR_IS_ASSIGNED, // to suppress usage warnings
 	ATTR_IS_USED, // to suppress usage warnings
+	ATTR_FAST_HASH, // for tables whose keys attackers can't control
 	NUM_ATTRS // this item should always be last
 	};
 
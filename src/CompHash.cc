@@ -61,10 +61,194 @@ const HashkeyMapPtr ordered_hashkeys(const TableVal* tv)
 	return res;
 	}
 
+// Moves offset up to the given alignment, zeroing the padding the same way
+// HashKey::AlignWrite() does.
+static inline size_t align_key_write(char* buf, size_t offset, size_t alignment)
+	{
+	size_t aligned = util::memory_size_align(offset, alignment);
+	memset(buf + offset, 0, aligned - offset);
+	return aligned;
+	}
+
 CompositeHash::CompositeHash(TypeListPtr composite_type) : type(std::move(composite_type))
 	{
-	if ( type->GetTypes().size() == 1 )
+	const auto& tl = type->GetTypes();
+
+	if ( tl.size() == 1 )
+		{
 		is_singleton = true;
+		return;
+		}
+
+	bool has_strings = false;
+
+	for ( const auto& t : tl )
+		{
+		switch ( t->InternalType() )
+			{
+			case TYPE_INTERNAL_INT:
+			case TYPE_INTERNAL_UNSIGNED:
+			case TYPE_INTERNAL_ADDR:
+			case TYPE_INTERNAL_SUBNET:
+			case TYPE_INTERNAL_DOUBLE:
+				break;
+
+			case TYPE_INTERNAL_STRING:
+				has_strings = true;
+				break;
+
+			default:
+				// Needs the generic code.
+				key_fields.clear();
+				return;
+			}
+
+		key_fields.push_back(t->InternalType());
+		}
+
+	if ( ! has_strings )
+		fixed_key_size = FieldsKeySize(nullptr, false);
+	}
+
+size_t CompositeHash::WriteKey(const Val& v, bool type_check, char* buf, size_t buf_size) const
+	{
+	if ( key_fields.empty() || v.GetType()->Tag() != TYPE_LIST )
+		return 0;
+
+	auto lv = v.AsListVal();
+	size_t size = FieldsKeySize(lv, type_check);
+
+	if ( size == 0 || size > buf_size )
+		return 0;
+
+	WriteFields(lv, buf);
+	return size;
+	}
+
+size_t CompositeHash::FieldsKeySize(const ListVal* lv, bool type_check) const
+	{
+	if ( lv )
+		{
+		if ( lv->Length() != static_cast<int>(key_fields.size()) )
+			return 0;
+
+		if ( type_check )
+			for ( auto i = 0u; i < key_fields.size(); ++i )
+				if ( lv->Idx(i)->GetType()->InternalType() != key_fields[i] )
+					return 0;
+
+		if ( fixed_key_size )
+			return fixed_key_size;
+		}
+
+	// The same layout as ReserveSingleTypeKeySize() computes.
+	size_t size = 0;
+
+	for ( auto i = 0u; i < key_fields.size(); ++i )
+		{
+		switch ( key_fields[i] )
+			{
+			case TYPE_INTERNAL_INT:
+			case TYPE_INTERNAL_UNSIGNED:
+				size = util::memory_size_align(size, sizeof(bro_int_t)) + sizeof(bro_int_t);
+				break;
+
+			case TYPE_INTERNAL_DOUBLE:
+				size = util::memory_size_align(size, sizeof(double)) + sizeof(double);
+				break;
+
+			case TYPE_INTERNAL_ADDR:
+				size = util::memory_size_align(size, sizeof(uint32_t)) + sizeof(uint32_t) * 4;
+				break;
+
+			case TYPE_INTERNAL_SUBNET:
+				size = util::memory_size_align(size, sizeof(uint32_t)) + sizeof(uint32_t) * 5;
+				break;
+
+			case TYPE_INTERNAL_STRING:
+				size = util::memory_size_align(size, sizeof(int)) + sizeof(int);
+				size += lv ? lv->Idx(i)->AsString()->Len() : 0;
+				break;
+
+			default:
+				reporter->InternalError("bad index type in CompositeHash::FieldsKeySize");
+			}
+		}
+
+	return size;
+	}
+
+void CompositeHash::WriteFields(const ListVal* lv, char* buf) const
+	{
+	// The same layout as SingleValHash() writes.
+	size_t offset = 0;
+
+	for ( auto i = 0u; i < key_fields.size(); ++i )
+		{
+		const Val* v = lv->Idx(i).get();
+
+		switch ( key_fields[i] )
+			{
+			case TYPE_INTERNAL_INT:
+				{
+				bro_int_t bi = v->AsInt();
+				offset = align_key_write(buf, offset, sizeof(bi));
+				memcpy(buf + offset, &bi, sizeof(bi));
+				offset += sizeof(bi);
+				break;
+				}
+
+			case TYPE_INTERNAL_UNSIGNED:
+				{
+				bro_uint_t bu = v->AsCount();
+				offset = align_key_write(buf, offset, sizeof(bu));
+				memcpy(buf + offset, &bu, sizeof(bu));
+				offset += sizeof(bu);
+				break;
+				}
+
+			case TYPE_INTERNAL_DOUBLE:
+				{
+				double d = v->InternalDouble();
+				offset = align_key_write(buf, offset, sizeof(d));
+				memcpy(buf + offset, &d, sizeof(d));
+				offset += sizeof(d);
+				break;
+				}
+
+			case TYPE_INTERNAL_ADDR:
+				offset = align_key_write(buf, offset, sizeof(uint32_t));
+				v->AsAddr().CopyIPv6(reinterpret_cast<uint32_t*>(buf + offset));
+				offset += sizeof(uint32_t) * 4;
+				break;
+
+			case TYPE_INTERNAL_SUBNET:
+				{
+				int width = v->AsSubNet().Length();
+				offset = align_key_write(buf, offset, sizeof(uint32_t));
+				v->AsSubNet().Prefix().CopyIPv6(reinterpret_cast<uint32_t*>(buf + offset));
+				offset += sizeof(uint32_t) * 4;
+				memcpy(buf + offset, &width, sizeof(width));
+				offset += sizeof(width);
+				break;
+				}
+
+			case TYPE_INTERNAL_STRING:
+				{
+				const String* s = v->AsString();
+				int len = s->Len();
+				offset = align_key_write(buf, offset, sizeof(len));
+				memcpy(buf + offset, &len, sizeof(len));
+				offset += sizeof(len);
+				memcpy(buf + offset, s->Bytes(), len);
+				offset += len;
+				break;
+				}
+
+			default:
+				reporter->InternalError("bad index type in CompositeHash::WriteFields");
+			}
+		}
 	}
 
 std::unique_ptr<HashKey> CompositeHash::MakeHashKey(const Val& argv, bool type_check) const
@@ -97,6 +281,20 @@ std::unique_ptr<HashKey> CompositeHash::MakeHashKey(const Val& argv, bool type_c
 	if ( type_check && argv.GetType()->Tag() != TYPE_LIST )
 		return nullptr;
 
+	if ( ! key_fields.empty() )
+		{
+		size_t size = FieldsKeySize(argv.AsListVal(), type_check);
+
+		if ( size == 0 )
+			return nullptr;
+
+		res->Reserve("fields", size);
+		res->Allocate();
+		WriteFields(argv.AsListVal(), static_cast<char*>(res->KeyAtWrite()));
+		res->SkipWrite("fields", size);
+		return res;
+		}
+
 	if ( ! ReserveKeySize(*res, &argv, type_check, false) )
 		return nullptr;
 
@@ -208,7 +406,7 @@ bool CompositeHash::RecoverOneVal(const HashKey& hk, Type* t, ValPtr* pval, bool
 			hk.Read("double", d);
 
 			if ( tag == TYPE_INTERVAL )
-				*pval = make_intrusive<IntervalVal>(d, 1.0);
+				*pval = val_mgr->Interval(d);
 			else if ( tag == TYPE_TIME )
 				*pval = make_intrusive<TimeVal>(d);
 			else
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "zeek/IntrusivePtr.h"
 #include "zeek/Type.h"
@@ -29,6 +30,17 @@ public:
 	// or nullptr if it fails to typecheck.
 	std::unique_ptr<HashKey> MakeHashKey(const Val& v, bool type_check) const;
 
+	// Size of a buffer that fits the keys of typical index types, for
+	// building them on the stack via WriteKey().
+	static constexpr size_t KEY_BUFFER_SIZE = 128;
+
+	// Writes the key for the given index val into buf, using the key
+	// builder specialized for the index type. Returns the key's size, or
+	// 0 if the index type has no such builder, the val doesn't typecheck,
+	// or the key would exceed buf_size; MakeHashKey() handles all those.
+	// The result matches what MakeHashKey() computes for the val.
+	size_t WriteKey(const Val& v, bool type_check, char* buf, size_t buf_size) const;
+
 	// Given a hash key, recover the values used to create it.
 	ListValPtr RecoverVals(const HashKey& k) const;
 
@@ -61,8 +73,26 @@ protected:
 
 	bool EnsureTypeReserve(HashKey& hk, const Val* v, Type* bt, bool type_check) const;
 
+	// Returns the size of the key the specialized builder produces for the
+	// given index val, or 0 if the val doesn't fit the index type.
+	size_t FieldsKeySize(const ListVal* lv, bool type_check) const;
+
+	// Writes the key for lv with the specialized builder into buf, which
+	// needs to hold FieldsKeySize() bytes.
+	void WriteFields(const ListVal* lv, char* buf) const;
+
 	TypeListPtr type;
 	bool is_singleton = false; // if just one type in index
+
+	// For index types made up of more than one atomic type, the internal
+	// types of the index fields, which is all the specialized key builder
+	// needs to go by. Empty for other index types, and for singletons,
+	// whose keys are already simple.
+	std::vector<InternalTypeTag> key_fields;
+
+	// Size of the keys built from key_fields, if it has no strings; 0 if
+	// it does.
+	size_t fixed_key_size = 0;
 	};
 
 	} // namespace zeek::detail
@@ -4,13 +4,107 @@
 
 #include "zeek/zeek-config.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 #include "zeek/Desc.h"
 #include "zeek/EquivClass.h"
 #include "zeek/Hash.h"
+#include "zeek/NetVar.h"
+#include "zeek/telemetry/Manager.h"
 
 namespace zeek::detail
 	{
 
+namespace
+	{
+
+// Totals across all DFA state caches. These may get updated from multiple
+// threads, see build_pending_dfas() and RuleMatcher::CompilePatternSets().
+std::atomic<int64_t> total_states = 0;
+std::atomic<int64_t> total_mem = 0;
+
+struct CacheMetrics
+	{
+	telemetry::IntGauge states;
+	telemetry::IntGauge mem;
+	telemetry::IntCounter hits;
+	telemetry::IntCounter misses;
+	telemetry::IntCounter evictions;
+	};
+
+// Returns nullptr until the telemetry manager exists, as patterns may get
+// compiled before that.
+CacheMetrics* metrics()
+	{
+	if ( ! telemetry_mgr )
+		return nullptr;
+
+	static CacheMetrics m = {
+		telemetry_mgr->GaugeSingleton("zeek", "dfa-states", "DFA states currently cached"),
+		telemetry_mgr->GaugeSingleton("zeek", "dfa-state-memory",
+	                                  "Memory used by cached DFA states", "bytes"),
+		telemetry_mgr->CounterSingleton("zeek", "dfa-cache-hits",
+	                                    "Computed DFA transitions leading to a cached state"),
+		telemetry_mgr->CounterSingleton("zeek", "dfa-cache-misses",
+	                                    "Computed DFA transitions requiring a new state"),
+		telemetry_mgr->CounterSingleton("zeek", "dfa-cache-evictions",
+	                                    "DFA states evicted because of dfa_max_state_memory"),
+	};
+
+	return &m;
+	}
+
+// Brings the gauges up to date with the totals. We don't do this when
+// caches get destroyed, which may happen after telemetry has shut down.
+void update_gauges(CacheMetrics* m)
+	{
+	static std::mutex mtx;
+	std::lock_guard<std::mutex> lock(mtx);
+
+	m->states.Inc(total_states - m->states.Value());
+	m->mem.Inc(total_mem - m->mem.Value());
+	}
+
+// Layout of DFA cache files, all in host byte order: the header, the
+// symbols' equivalence classes (int32_t each), the number of accepted
+// pattern indices per state (uint32_t each), all of those indices (int32_t
+// each), the transitions as in DFA_DenseTable (uint16_t each, row by row),
+// and finally the key.
+constexpr uint32_t CACHE_MAGIC = 0x5a444641; // "ZDFA"
+
+// Bump this whenever the layout or the meaning of its parts changes.
+constexpr uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader
+	{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t ec_size;
+	uint32_t num_sym;
+	uint32_t num_states;
+	uint32_t start_state;
+	uint32_t num_accepts;
+	uint32_t key_len;
+	};
+
+size_t cache_file_size(const CacheHeader& hdr)
+	{
+	return sizeof(hdr) + sizeof(int32_t) * hdr.ec_size + sizeof(uint32_t) * hdr.num_states +
+	       sizeof(int32_t) * hdr.num_accepts +
+	       sizeof(uint16_t) * size_t(hdr.num_states) * hdr.num_sym + hdr.key_len;
+	}
+
+	} // namespace
+
 unsigned int DFA_State::transition_counter = 0;
 
 DFA_State::DFA_State(int arg_state_num, const EquivClass* ec, NFA_state_list* arg_nfa_states,
@@ -21,6 +115,9 @@ DFA_State::DFA_State(int arg_state_num, const EquivClass* ec, NFA_state_list* ar
 	nfa_states = arg_nfa_states;
 	accept = arg_accept;
 	mark = nullptr;
+	last_used = 0;
+	evicted = false;
+	dense_idx = -1;
 
 	SymPartition(ec);
 
@@ -30,6 +127,24 @@ DFA_State::DFA_State(int arg_state_num, const EquivClass* ec, NFA_state_list* ar
 		xtions[i] = DFA_UNCOMPUTED_STATE_PTR;
 	}
 
+DFA_State::DFA_State(int arg_state_num, int arg_num_sym, AcceptingSet* arg_accept)
+	{
+	state_num = arg_state_num;
+	num_sym = arg_num_sym;
+	nfa_states = nullptr;
+	accept = arg_accept;
+	meta_ec = nullptr;
+	mark = nullptr;
+	last_used = 0;
+	evicted = false;
+	dense_idx = -1;
+
+	xtions = new DFA_State*[num_sym];
+
+	for ( int i = 0; i < num_sym; ++i )
+		xtions[i] = DFA_UNCOMPUTED_STATE_PTR;
+	}
+
 DFA_State::~DFA_State()
 	{
 	delete[] xtions;
@@ -82,11 +197,18 @@ DFA_State* DFA_State::ComputeXtion(int sym, DFA_Machine* machine)
 	if ( xtions[equiv_sym] != DFA_UNCOMPUTED_STATE_PTR )
 		{
 		AddXtion(sym, xtions[equiv_sym]);
+
+		if ( machine->dense )
+			machine->dense->Update(this, sym, xtions[sym]);
+
 		return xtions[sym];
 		}
 
 	const EquivClass* ec = machine->EC();
 
+	if ( ! evicted )
+		machine->Cache()->Touch(this);
+
 	DFA_State* next_d;
 
 	NFA_state_list* ns = SymFollowSet(equiv_sym, ec);
@@ -102,10 +224,22 @@ DFA_State* DFA_State::ComputeXtion(int sym, DFA_Machine* machine)
 		next_d = nullptr; // Jam
 		}
 
+	// An evicted state may get freed any time, so nothing may point
+	// to it; we merely pass through it once more.
+	if ( evicted )
+		return next_d;
+
 	AddXtion(equiv_sym, next_d);
 	if ( sym != equiv_sym )
 		AddXtion(sym, next_d);
 
+	if ( machine->dense )
+		{
+		machine->dense->Update(this, equiv_sym, next_d);
+		if ( sym != equiv_sym )
+			machine->dense->Update(this, sym, next_d);
+		}
+
 	return xtions[sym];
 	}
 
@@ -292,6 +426,8 @@ unsigned int DFA_State::Size()
 DFA_State_Cache::DFA_State_Cache()
 	{
 	hits = misses = 0;
+	clock = 0;
+	mem = 0;
 	}
 
 DFA_State_Cache::~DFA_State_Cache()
@@ -302,6 +438,9 @@ DFA_State_Cache::~DFA_State_Cache()
 		Unref(entry.second);
 		}
 
+	total_states -= states.size();
+	total_mem -= mem;
+
 	states.clear();
 	}
 
@@ -340,11 +479,19 @@ DFA_State* DFA_State_Cache::Lookup(const NFA_state_list& nfas, DigestStr* digest
 	if ( entry == states.end() )
 		{
 		++misses;
+
+		if ( auto m = metrics() )
+			m->misses.Inc();
+
 		return nullptr;
 		}
 	++hits;
 
+	if ( auto m = metrics() )
+		m->hits.Inc();
+
 	digest->clear();
+	Touch(entry->second);
 
 	return entry->second;
 	}
@@ -352,9 +499,87 @@ DFA_State* DFA_State_Cache::Lookup(const NFA_state_list& nfas, DigestStr* digest
 DFA_State* DFA_State_Cache::Insert(DFA_State* state, DigestStr digest)
 	{
 	states.emplace(std::move(digest), state);
+	Touch(state);
+
+	size_t size = util::pad_size(state->Size()) + padded_sizeof(*state);
+	mem += size;
+	total_mem += size;
+	++total_states;
+
+	if ( auto m = metrics() )
+		update_gauges(m);
+
 	return state;
 	}
 
+void DFA_State_Cache::Evict(size_t target, DFA_State* keep)
+	{
+	std::vector<DFA_State*> by_age;
+	by_age.reserve(states.size());
+
+	for ( const auto& entry : states )
+		if ( entry.second != keep )
+			by_age.push_back(entry.second);
+
+	std::sort(by_age.begin(), by_age.end(), [](const DFA_State* a, const DFA_State* b)
+	          { return a->last_used < b->last_used; });
+
+	size_t num_evicted = 0;
+
+	for ( auto s : by_age )
+		{
+		if ( mem <= target )
+			break;
+
+		size_t size = util::pad_size(s->Size()) + padded_sizeof(*s);
+		mem -= size;
+		total_mem -= size;
+		s->evicted = true;
+		s->dense_idx = -1;
+		++num_evicted;
+		}
+
+	if ( ! num_evicted )
+		return;
+
+	// Drop all transitions into evicted states first, so that nothing
+	// in the cache refers to them anymore once we release them.
+	for ( const auto& entry : states )
+		{
+		DFA_State* s = entry.second;
+
+		for ( int i = 0; i < s->num_sym; ++i )
+			{
+			DFA_State* next = s->xtions[i];
+
+			if ( s->evicted ||
+			     (next && next != DFA_UNCOMPUTED_STATE_PTR && next->evicted) )
+				s->xtions[i] = DFA_UNCOMPUTED_STATE_PTR;
+			}
+		}
+
+	for ( auto it = states.begin(); it != states.end(); )
+		{
+		DFA_State* s = it->second;
+
+		if ( s->evicted )
+			{
+			it = states.erase(it);
+			Unref(s);
+			}
+		else
+			++it;
+		}
+
+	total_states -= num_evicted;
+
+	if ( auto m = metrics() )
+		{
+		m->evictions.Inc(num_evicted);
+		update_gauges(m);
+		}
+	}
+
 void DFA_State_Cache::GetStats(Stats* s)
 	{
 	s->dfa_states = 0;
@@ -375,9 +600,73 @@ void DFA_State_Cache::GetStats(Stats* s)
 		}
 	}
 
+DFA_DenseTable::DFA_DenseTable(DFA_State_Cache* cache, int arg_num_sym)
+	{
+	num_sym = arg_num_sym;
+	built_at = cache->NumEntries();
+
+	size_t n = cache->states.size();
+
+	if ( n >= JAM || n * num_sym > MAX_ENTRIES )
+		{
+		for ( const auto& entry : cache->states )
+			entry.second->dense_idx = -1;
+
+		return;
+		}
+
+	states.reserve(n);
+
+	for ( const auto& entry : cache->states )
+		{
+		entry.second->dense_idx = states.size();
+		states.push_back(entry.second);
+		}
+
+	xtions.resize(n * num_sym);
+	accepting.resize((n + 63) / 64);
+
+	for ( size_t i = 0; i < n; ++i )
+		{
+		DFA_State* s = states[i];
+
+		if ( s->accept )
+			accepting[i >> 6] |= uint64_t(1) << (i & 63);
+
+		for ( int sym = 0; sym < num_sym; ++sym )
+			{
+			// Everything the cached states lead to is cached itself.
+			DFA_State* next = s->xtions[sym];
+
+			if ( ! next )
+				xtions[i * num_sym + sym] = JAM;
+			else if ( next == DFA_UNCOMPUTED_STATE_PTR )
+				xtions[i * num_sym + sym] = UNCOMPUTED;
+			else
+				xtions[i * num_sym + sym] = next->dense_idx;
+			}
+		}
+	}
+
+void DFA_DenseTable::Update(DFA_State* from, int sym, DFA_State* to)
+	{
+	if ( from->dense_idx < 0 )
+		return;
+
+	uint16_t next = UNCOMPUTED;
+
+	if ( ! to )
+		next = JAM;
+	else if ( to->dense_idx >= 0 )
+		next = to->dense_idx;
+
+	xtions[from->dense_idx * num_sym + sym] = next;
+	}
+
 DFA_Machine::DFA_Machine(NFA_Machine* n, EquivClass* arg_ec)
 	{
 	state_count = 0;
+	complete = false;
 
 	nfa = n;
 	Ref(n);
@@ -401,12 +690,262 @@ DFA_Machine::DFA_Machine(NFA_Machine* n, EquivClass* arg_ec)
 		}
 	}
 
+DFA_Machine::DFA_Machine(EquivClass* arg_ec)
+	{
+	state_count = 0;
+	complete = false;
+	nfa = nullptr;
+	ec = arg_ec;
+	start_state = nullptr;
+	dfa_state_cache = new DFA_State_Cache();
+	}
+
 DFA_Machine::~DFA_Machine()
 	{
 	delete dfa_state_cache;
 	Unref(nfa);
 	}
 
+void DFA_Machine::Precompute(int max_states)
+	{
+	if ( ! start_state || complete )
+		return;
+
+	std::vector<DFA_State*> queue{start_state};
+	std::unordered_set<DFA_State*> seen{start_state};
+	int num_sym = ec->NumClasses();
+
+	for ( size_t i = 0; i < queue.size(); ++i )
+		{
+		for ( int sym = 0; sym < num_sym; ++sym )
+			{
+			if ( NumStates() >= max_states ||
+			     (dfa_max_state_memory &&
+			      dfa_state_cache->Memory() > dfa_max_state_memory / 2) )
+				return;
+
+			DFA_State* next = queue[i]->Xtion(sym, this);
+
+			if ( next && seen.insert(next).second )
+				queue.push_back(next);
+			}
+		}
+
+	complete = true;
+	}
+
+bool DFA_Machine::Save(const std::string& path, const std::string& key)
+	{
+	if ( ! complete || ! nfa )
+		return false;
+
+	// Index the states afresh, so that the table covers all of them.
+	dense = std::make_unique<DFA_DenseTable>(dfa_state_cache, ec->NumClasses());
+
+	if ( ! dense->Valid() )
+		return false;
+
+	CacheHeader hdr;
+	hdr.magic = CACHE_MAGIC;
+	hdr.version = CACHE_VERSION;
+	hdr.ec_size = ec->NumSyms();
+	hdr.num_sym = ec->NumClasses();
+	hdr.num_states = dense->NumStates();
+	hdr.start_state = start_state->DenseIndex();
+	hdr.key_len = key.size();
+
+	std::vector<int32_t> classes(ec->EquivClasses(), ec->EquivClasses() + hdr.ec_size);
+	std::vector<uint32_t> num_accepts;
+	std::vector<int32_t> accepts;
+	std::vector<uint16_t> xtions;
+	xtions.reserve(size_t(hdr.num_states) * hdr.num_sym);
+
+	for ( int i = 0; i < dense->NumStates(); ++i )
+		{
+		const AcceptingSet* a = dense->State(i)->Accept();
+		num_accepts.push_back(a ? a->size() : 0);
+
+		if ( a )
+			accepts.insert(accepts.end(), a->begin(), a->end());
+
+		for ( int sym = 0; sym < ec->NumClasses(); ++sym )
+			{
+			uint16_t next = dense->Next(i, sym);
+
+			if ( next == DFA_DenseTable::UNCOMPUTED )
+				return false;
+
+			xtions.push_back(next);
+			}
+		}
+
+	hdr.num_accepts = accepts.size();
+
+	// Write to a temporary file first, so that other processes loading
+	// the cache concurrently never see a partial file. Threads saving
+	// identical groups each get their own.
+	static std::atomic<unsigned int> tmp_counter = 0;
+	std::string tmp = path + ".tmp." + std::to_string(getpid()) + "." +
+	                  std::to_string(++tmp_counter);
+	FILE* f = fopen(tmp.c_str(), "wb");
+
+	if ( ! f )
+		return false;
+
+	bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+	          fwrite(classes.data(), sizeof(int32_t), classes.size(), f) == classes.size() &&
+	          fwrite(num_accepts.data(), sizeof(uint32_t), num_accepts.size(), f) ==
+	              num_accepts.size() &&
+	          fwrite(accepts.data(), sizeof(int32_t), accepts.size(), f) == accepts.size() &&
+	          fwrite(xtions.data(), sizeof(uint16_t), xtions.size(), f) == xtions.size() &&
+	          fwrite(key.data(), 1, key.size(), f) == key.size();
+
+	if ( fclose(f) != 0 || ! ok || rename(tmp.c_str(), path.c_str()) != 0 )
+		{
+		unlink(tmp.c_str());
+		return false;
+		}
+
+	return true;
+	}
+
+DFA_Machine* DFA_Machine::Load(const std::string& path, const std::string& key, EquivClass* ec)
+	{
+	int fd = open(path.c_str(), O_RDONLY);
+
+	if ( fd < 0 )
+		return nullptr;
+
+	struct stat st;
+
+	if ( fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader) )
+		{
+		close(fd);
+		return nullptr;
+		}
+
+	size_t len = st.st_size;
+	void* data = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if ( data == MAP_FAILED )
+		return nullptr;
+
+	auto unmap = [data, len]()
+	{
+		munmap(data, len);
+	};
+
+	const CacheHeader* hdr = static_cast<const CacheHeader*>(data);
+
+	if ( hdr->magic != CACHE_MAGIC || hdr->version != CACHE_VERSION ||
+	     hdr->ec_size != static_cast<uint32_t>(ec->NumSyms()) || hdr->num_sym == 0 ||
+	     hdr->num_sym > hdr->ec_size || hdr->num_states == 0 ||
+	     hdr->num_states >= DFA_DenseTable::JAM || hdr->start_state >= hdr->num_states ||
+	     hdr->key_len != key.size() || cache_file_size(*hdr) != len )
+		{
+		unmap();
+		return nullptr;
+		}
+
+	auto classes = reinterpret_cast<const int32_t*>(hdr + 1);
+	auto num_accepts = reinterpret_cast<const uint32_t*>(classes + hdr->ec_size);
+	auto accepts = reinterpret_cast<const int32_t*>(num_accepts + hdr->num_states);
+	auto xtions = reinterpret_cast<const uint16_t*>(accepts + hdr->num_accepts);
+	auto file_key = reinterpret_cast<const char*>(xtions + size_t(hdr->num_states) * hdr->num_sym);
+
+	// Check everything we'll use as an index, so that a damaged file
+	// can't lead us astray.
+	bool ok = memcmp(file_key, key.data(), key.size()) == 0;
+	int32_t max_class = -1;
+	uint64_t total_accepts = 0;
+
+	for ( uint32_t i = 0; ok && i < hdr->ec_size; ++i )
+		{
+		ok = classes[i] >= 0 && static_cast<uint32_t>(classes[i]) < hdr->num_sym;
+		max_class = std::max(max_class, classes[i]);
+		}
+
+	for ( uint32_t i = 0; ok && i < hdr->num_states; ++i )
+		total_accepts += num_accepts[i];
+
+	for ( size_t i = 0; ok && i < size_t(hdr->num_states) * hdr->num_sym; ++i )
+		ok = xtions[i] < hdr->num_states || xtions[i] == DFA_DenseTable::JAM;
+
+	if ( ! ok || static_cast<uint32_t>(max_class) + 1 != hdr->num_sym ||
+	     total_accepts != hdr->num_accepts )
+		{
+		unmap();
+		return nullptr;
+		}
+
+	std::vector<int> ec_classes(classes, classes + hdr->ec_size);
+	ec->Restore(ec_classes.data());
+
+	DFA_Machine* m = new DFA_Machine(ec);
+	std::vector<DFA_State*> states(hdr->num_states);
+
+	for ( uint32_t i = 0; i < hdr->num_states; ++i )
+		{
+		AcceptingSet* accept = nullptr;
+
+		if ( num_accepts[i] )
+			{
+			accept = new AcceptingSet(accepts, accepts + num_accepts[i]);
+			accepts += num_accepts[i];
+			}
+
+		states[i] = new DFA_State(i, hdr->num_sym, accept);
+
+		// The cache never looks these up by their NFA states, so any
+		// unique digest will do.
+		DigestStr digest(16, 0);
+		memcpy(&digest[0], &i, sizeof(i));
+		m->dfa_state_cache->Insert(states[i], std::move(digest));
+		}
+
+	for ( uint32_t i = 0; i < hdr->num_states; ++i )
+		for ( uint32_t sym = 0; sym < hdr->num_sym; ++sym )
+			{
+			uint16_t next = xtions[i * hdr->num_sym + sym];
+			states[i]->AddXtion(sym, next == DFA_DenseTable::JAM ? nullptr : states[next]);
+			}
+
+	m->start_state = states[hdr->start_state];
+	m->state_count = hdr->num_states;
+	m->complete = true;
+
+	unmap();
+	return m;
+	}
+
+const DFA_DenseTable* DFA_Machine::Dense()
+	{
+	// Rebuild once a quarter more states have come along, so that the
+	// cost of rebuilding stays proportional to the DFA's growth.
+	if ( ! dense || NumStates() >= dense->BuiltAt() + dense->BuiltAt() / 4 + 8 )
+		dense = std::make_unique<DFA_DenseTable>(dfa_state_cache, ec->NumClasses());
+
+	return dense->Valid() ? dense.get() : nullptr;
+	}
+
+void DFA_Machine::Prune()
+	{
+	// Without an NFA, evicted states couldn't be computed again.
+	if ( ! nfa )
+		return;
+
+	if ( dfa_max_state_memory && dfa_state_cache->Memory() > dfa_max_state_memory )
+		{
+		// Free up half of the budget so that we don't need to come
+		// back right away.
+		dfa_state_cache->Evict(dfa_max_state_memory / 2, start_state);
+
+		// The table may refer to evicted states.
+		dense.reset();
+		}
+	}
+
 void DFA_Machine::Describe(ODesc* d) const
 	{
 	d->Add("DFA machine");
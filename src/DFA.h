@@ -4,8 +4,11 @@
 
 #include <assert.h>
 #include <sys/types.h> // for u_char
-#include <map>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "zeek/NFA.h"
 #include "zeek/Obj.h"
@@ -27,10 +30,15 @@ class DFA_State : public Obj
 public:
 	DFA_State(int state_num, const EquivClass* ec, NFA_state_list* nfa_states,
 	          AcceptingSet* accept);
+
+	// A state restored from a DFA cache file. It has no NFA states, so
+	// all of its transitions need to be added before use.
+	DFA_State(int state_num, int num_sym, AcceptingSet* accept);
+
 	~DFA_State() override;
 
 	int StateNum() const { return state_num; }
-	int NFAStateNum() const { return nfa_states->length(); }
+	int NFAStateNum() const { return nfa_states ? nfa_states->length() : 0; }
 	void AddXtion(int sym, DFA_State* next_state);
 
 	inline DFA_State* Xtion(int sym, DFA_Machine* machine);
@@ -48,6 +56,12 @@ public:
 	// Returns the equivalence classes of ec's corresponding to this state.
 	const EquivClass* MetaECs() const { return meta_ec; }
 
+	// Returns the state's row in its machine's DFA_DenseTable, or -1.
+	int DenseIndex() const { return dense_idx; }
+
+	// True if the state has been evicted from its machine's cache.
+	bool Evicted() const { return evicted; }
+
 	void Describe(ODesc* d) const override;
 	void Dump(FILE* f, DFA_Machine* m);
 	void Stats(unsigned int* computed, unsigned int* uncomputed);
@@ -55,6 +69,7 @@ public:
 
 protected:
 	friend class DFA_State_Cache;
+	friend class DFA_DenseTable;
 
 	DFA_State* ComputeXtion(int sym, DFA_Machine* machine);
 	void AppendIfNew(int sym, int_list* sym_list);
@@ -69,6 +84,10 @@ protected:
 	EquivClass* meta_ec; // which ec's make same transition
 	DFA_State* mark;
 
+	uint64_t last_used; // see DFA_State_Cache::Touch()
+	bool evicted; // no longer cached; doesn't keep any transitions
+	int dense_idx;
+
 	static unsigned int transition_counter; // see Xtion()
 	};
 
@@ -88,6 +107,18 @@ public:
 
 	int NumEntries() const { return states.size(); }
 
+	// Marks the state as recently used.
+	void Touch(DFA_State* state) { state->last_used = ++clock; }
+
+	// Returns the number of bytes the cached states use.
+	size_t Memory() const { return mem; }
+
+	// Evicts least recently used states other than keep until at most
+	// target bytes remain. Transitions into evicted states revert to
+	// uncomputed. Evicted states stay alive as long as someone holds a
+	// reference to them, but no longer record transitions of their own.
+	void Evict(size_t target, DFA_State* keep);
+
 	struct Stats
 		{
 		// Sum of all NFA states
@@ -103,11 +134,71 @@ public:
 	void GetStats(Stats* s);
 
 private:
+	friend class DFA_DenseTable;
+
+	// Digests are hashes already, so just use their leading bytes.
+	struct DigestHash
+		{
+		size_t operator()(const DigestStr& digest) const
+			{
+			size_t h;
+			memcpy(&h, digest.data(), sizeof(h));
+			return h;
+			}
+		};
+
 	int hits; // Statistics
 	int misses;
 
+	uint64_t clock; // for Touch()
+	size_t mem;
+
 	// Hash indexed by NFA states (MD5s of them, actually).
-	std::map<DigestStr, DFA_State*> states;
+	std::unordered_map<DigestStr, DFA_State*, DigestHash> states;
+	};
+
+// A compact copy of the transitions computed so far, for matching with
+// fewer and more local memory accesses: states are rows of a contiguous
+// table of 16-bit state indices, and accepting states are flagged in a
+// bitmap. Transitions that weren't known when the table was built lead to
+// UNCOMPUTED unless filled in later through Update(), and states added
+// afterwards have no row; matching then falls back to the DFA_States.
+class DFA_DenseTable
+	{
+public:
+	static constexpr uint16_t UNCOMPUTED = 0xffff;
+	static constexpr uint16_t JAM = 0xfffe;
+
+	// Maximum number of table entries we're willing to allocate.
+	static constexpr size_t MAX_ENTRIES = 1 << 22;
+
+	// Indexes all states currently in the cache.
+	DFA_DenseTable(DFA_State_Cache* cache, int num_sym);
+
+	// Returns false if the cache was too large to build the table.
+	bool Valid() const { return ! states.empty(); }
+
+	// Number of cached states at the time the table was built.
+	int BuiltAt() const { return built_at; }
+
+	// Number of rows.
+	int NumStates() const { return states.size(); }
+
+	uint16_t Next(int state, int sym) const { return xtions[state * num_sym + sym]; }
+
+	bool Accepting(int state) const { return accepting[state >> 6] & (uint64_t(1) << (state & 63)); }
+
+	DFA_State* State(int state) const { return states[state]; }
+
+	// Records a transition computed after building the table.
+	void Update(DFA_State* from, int sym, DFA_State* to);
+
+private:
+	int num_sym;
+	int built_at;
+	std::vector<DFA_State*> states;
+	std::vector<uint16_t> xtions;
+	std::vector<uint64_t> accepting;
 	};
 
 class DFA_Machine : public Obj
@@ -122,6 +213,40 @@ public:
 
 	DFA_State_Cache* Cache() { return dfa_state_cache; }
 
+	// Computes states and their transitions breadth-first from the start
+	// state, until there are max_states states or the DFA is complete.
+	// Also stops at half of dfa_max_state_memory, if set, so that the
+	// result doesn't get evicted right away.
+	void Precompute(int max_states);
+
+	// True if Precompute() has computed all states and transitions, or
+	// if the machine came from Load().
+	bool Complete() const { return complete; }
+
+	// Writes a complete machine to a DFA cache file at path, along with
+	// the equivalence classes. The key identifies the patterns the
+	// machine was built from. Returns false if the machine isn't
+	// complete or the file can't be written.
+	bool Save(const std::string& path, const std::string& key);
+
+	// Reads a machine from a DFA cache file written by Save() with the
+	// same key, restoring its equivalence classes into ec. The file gets
+	// mapped into memory rather than read. Returns nullptr if there's no
+	// such file or it doesn't fit. Loaded machines have no NFA and thus
+	// never evict states.
+	static DFA_Machine* Load(const std::string& path, const std::string& key, EquivClass* ec);
+
+	// Returns the machine's dense table, (re)building it first if enough
+	// new states have accumulated. Returns nullptr if there's none. Like
+	// Prune(), this must not be called in the middle of matching.
+	const DFA_DenseTable* Dense();
+
+	// Evicts cold states if the cache has grown beyond
+	// dfa_max_state_memory. Must not be called while anybody holds on
+	// to a state without a reference, i.e., not in the middle of
+	// matching.
+	void Prune();
+
 	int Rep(int sym);
 
 	void Describe(ODesc* d) const override;
@@ -135,7 +260,11 @@ protected:
 	friend class DFA_State; // for DFA_State::ComputeXtion
 	friend class DFA_State_Cache;
 
+	// For Load().
+	explicit DFA_Machine(EquivClass* ec);
+
 	int state_count;
+	bool complete;
 
 	// The state list has to be sorted according to IDs.
 	bool StateSetToDFA_State(NFA_state_list* state_set, DFA_State*& d, const EquivClass* ec);
@@ -144,6 +273,7 @@ protected:
 	EquivClass* ec; // equivalence classes corresponding to NFAs
 	DFA_State* start_state;
 	DFA_State_Cache* dfa_state_cache;
+	std::unique_ptr<DFA_DenseTable> dense;
 
 	NFA_Machine* nfa;
 	};
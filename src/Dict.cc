@@ -10,8 +10,15 @@
 #include <signal.h>
 #include <algorithm>
 #include <climits>
+#include <chrono>
 #include <fstream>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "zeek/3rdparty/doctest.h"
 #include "zeek/Reporter.h"
 #include "zeek/util.h"
@@ -602,6 +609,182 @@ TEST_CASE("dict iterator invalidation")
 	delete key3;
 	}
 
+TEST_CASE("dict probing")
+	{
+	PDict<uint64_t> dict;
+	std::vector<uint64_t> vals(5000);
+
+	// Enough entries for several resizes and remaps, with some of them removed
+	// again to shorten clusters.
+	for ( uint64_t i = 0; i < vals.size(); i++ )
+		{
+		vals[i] = i;
+		detail::HashKey key(i);
+		dict.Insert(&key, &vals[i]);
+		}
+
+	for ( uint64_t i = 0; i < vals.size(); i += 3 )
+		{
+		detail::HashKey key(i);
+		dict.Remove(&key);
+		}
+
+	for ( uint64_t i = 0; i < vals.size(); i++ )
+		{
+		detail::HashKey key(i);
+		uint64_t* v = dict.Lookup(&key);
+		if ( i % 3 == 0 )
+			CHECK(v == nullptr);
+		else
+			CHECK((v && *v == i));
+		}
+
+	int n = 0;
+	for ( auto it = dict.begin(); it != dict.end(); ++it )
+		n++;
+	CHECK(n == dict.Length());
+
+	// Entries sharing a hash all end up in one cluster, long enough to
+	// saturate the distances kept in the control words.
+	Dictionary same_hash;
+	for ( uint64_t i = 0; i < 400; i++ )
+		same_hash.Insert(&i, sizeof(i), 42, &vals[i], true);
+
+	for ( uint64_t i = 0; i < 400; i += 2 )
+		same_hash.Remove(&i, sizeof(i), 42);
+
+	for ( uint64_t i = 0; i < 400; i++ )
+		{
+		void* v = same_hash.Lookup(&i, sizeof(i), 42);
+		CHECK(v == (i % 2 ? &vals[i] : nullptr));
+		}
+	}
+
+TEST_CASE("dict control word tags")
+	{
+	// Hashes that only differ in their top bits end up in the same bucket,
+	// eight per bucket here. Their tags should still keep lookups from
+	// comparing keys with the other entries of the bucket.
+	auto hash_of = [](uint64_t bucket, uint64_t n) { return detail::hash_t((n << 24) | bucket); };
+
+	Dictionary dict;
+	std::vector<uint64_t> vals(4096);
+
+	for ( uint64_t i = 0; i < vals.size(); i++ )
+		{
+		vals[i] = i;
+		dict.Insert(&vals[i], sizeof(vals[i]), hash_of(i / 8, i % 8), &vals[i], true);
+		}
+
+	uint64_t before = dict.NumKeyComparisons();
+
+	for ( uint64_t i = 0; i < vals.size(); i++ )
+		CHECK(dict.Lookup(&vals[i], sizeof(vals[i]), hash_of(i / 8, i % 8)) == &vals[i]);
+
+	// Comparing keys with all entries ahead in the bucket would take 4.5
+	// comparisons per lookup.
+	CHECK(dict.NumKeyComparisons() - before < vals.size() + vals.size() / 4);
+
+	before = dict.NumKeyComparisons();
+
+	for ( uint64_t i = 0; i < vals.size(); i += 8 )
+		{
+		uint64_t absent = vals.size() + i;
+		CHECK(dict.Lookup(&absent, sizeof(absent), hash_of(i / 8, 8)) == nullptr);
+		}
+
+	CHECK(dict.NumKeyComparisons() - before < vals.size() / 8 / 4);
+	}
+
+TEST_CASE("dict lookup by hash")
+	{
+	// Entries sharing a hash, told apart by their values.
+	Dictionary dict;
+	std::vector<uint64_t> vals(64);
+
+	for ( uint64_t i = 0; i < vals.size(); i++ )
+		{
+		vals[i] = i;
+		dict.Insert(&vals[i], sizeof(vals[i]), detail::hash_t(i % 4 + 1), &vals[i], true);
+		}
+
+	for ( uint64_t i = 0; i < vals.size(); i++ )
+		{
+		auto is_i = [i](const void* v) { return *static_cast<const uint64_t*>(v) == i; };
+		std::unique_ptr<detail::HashKey> key;
+
+		CHECK(dict.LookupByHash(i % 4 + 1, is_i, &key) == &vals[i]);
+		REQUIRE(key);
+		CHECK(key->Size() == sizeof(vals[i]));
+		CHECK(memcmp(key->Key(), &vals[i], sizeof(vals[i])) == 0);
+
+		CHECK(dict.LookupByHash((i + 1) % 4 + 1, is_i) == nullptr);
+		}
+
+	auto any = [](const void* v) { return true; };
+	CHECK(dict.LookupByHash(5, any) == nullptr);
+	}
+
+TEST_CASE("dict benchmark" * doctest::skip())
+	{
+	// Timings for comparing changes of the table layout. Run with
+	// "zeek --test -tc='dict benchmark' -ns".
+	const uint64_t n = 1000000;
+	std::vector<uint64_t> vals(n);
+	PDict<uint64_t> dict;
+
+	auto time = [](const char* what, auto f)
+		{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+		MESSAGE(what << ": " << secs.count() << " secs");
+		};
+
+	time("insert", [&]()
+	     {
+		     for ( uint64_t i = 0; i < n; i++ )
+			     {
+			     detail::HashKey key(i);
+			     dict.Insert(&key, &vals[i]);
+			     }
+	     });
+
+	uint64_t found = 0;
+	time("lookup, hits and misses", [&]()
+	     {
+		     for ( uint64_t i = 0; i < 2 * n; i++ )
+			     {
+			     detail::HashKey key(i);
+			     found += dict.Lookup(&key) != nullptr;
+			     }
+	     });
+	CHECK(found == n);
+
+	time("iterate", [&]()
+	     {
+		     for ( const auto& entry : dict )
+			     found += entry.GetValue<uint64_t*>() != nullptr;
+	     });
+
+	time("remove half, insert again", [&]()
+	     {
+		     for ( uint64_t i = 0; i < n; i += 2 )
+			     {
+			     detail::HashKey key(i);
+			     dict.Remove(&key);
+			     }
+
+		     for ( uint64_t i = 0; i < n; i += 2 )
+			     {
+			     detail::HashKey key(i);
+			     dict.Insert(&key, &vals[i]);
+			     }
+	     });
+
+	CHECK(dict.Length() == static_cast<int>(n));
+	}
+
 TEST_SUITE_END();
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -738,7 +921,7 @@ int Dictionary::Next(int position) const
 	do
 		{
 		position++;
-		} while ( position < Capacity() && table[position].Empty() );
+		} while ( position < Capacity() && ! ctrl[position] );
 
 	return position;
 	}
@@ -981,6 +1164,8 @@ void Dictionary::Clear()
 			}
 		free(table);
 		table = nullptr;
+		free(ctrl);
+		ctrl = nullptr;
 		}
 
 	if ( order )
@@ -1012,6 +1197,7 @@ void Dictionary::Init()
 	table = (detail::DictEntry*)malloc(sizeof(detail::DictEntry) * Capacity(true));
 	for ( int i = Capacity() - 1; i >= 0; i-- )
 		table[i].SetEmpty();
+	ctrl = (uint16_t*)calloc(Capacity(true), sizeof(uint16_t));
 	}
 
 // private
@@ -1038,6 +1224,32 @@ void* Dictionary::Lookup(const void* key, int key_size, detail::hash_t h) const
 	return position >= 0 ? table[position].value : nullptr;
 	}
 
+void* Dictionary::LookupByHash(detail::hash_t h, const std::function<bool(const void*)>& match,
+                               std::unique_ptr<detail::HashKey>* key) const
+	{
+	if ( ! table )
+		return nullptr;
+
+	int position = LookupIndexByHash(h, match, BucketByHash(h, log2_buckets), Capacity());
+
+	// Without remapping, as we're not after the key, but the entry may
+	// still sit where a previous table size put it.
+	for ( int i = 1; position < 0 && i <= remaps; i++ )
+		{
+		int prev_bucket = BucketByHash(h, log2_buckets - i);
+		if ( prev_bucket <= remap_end )
+			position = LookupIndexByHash(h, match, prev_bucket, remap_end + 1);
+		}
+
+	if ( position < 0 )
+		return nullptr;
+
+	if ( key )
+		*key = table[position].GetHashKey();
+
+	return table[position].value;
+	}
+
 // for verification purposes
 int Dictionary::LinearLookupIndex(const void* key, int key_size, detail::hash_t hash) const
 	{
@@ -1101,6 +1313,53 @@ int Dictionary::LookupIndex(const void* key, int key_size, detail::hash_t hash,
 	return -1;
 	}
 
+// The control word for an entry with the given hash and distance. The tag
+// comes from the top bits of the 32 that count, as the bucket is made of the
+// low bits of FibHash(), which in turn only depend on the low bits of the hash.
+static inline uint16_t control_word(detail::hash_t hash, int distance)
+	{
+	return ((uint32_t(hash) >> 24) << 8) | std::min(distance + 1, 0xFF);
+	}
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+#define PROBE_GROUP 8
+
+// Compares a group of PROBE_GROUP control words with the ones an entry of the
+// probed bucket would have there, given the first of them. Sets the bit masks
+// of positions matching it, and of positions ending the probe because they are
+// empty or hold entries of later buckets. Each position takes
+// PROBE_LANE_BITS bits of the masks.
+#if defined(__SSE2__)
+#define PROBE_LANE_BITS 2
+
+static inline void probe_group(const uint16_t* ctrl, uint16_t first, uint64_t* match,
+                               uint64_t* stop)
+	{
+	const __m128i low = _mm_set1_epi16(0xFF);
+	__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+	__m128i expected = _mm_add_epi16(_mm_set1_epi16(first), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+	*match = _mm_movemask_epi8(_mm_cmpeq_epi16(words, expected));
+	*stop = _mm_movemask_epi8(
+		_mm_cmplt_epi16(_mm_and_si128(words, low), _mm_and_si128(expected, low)));
+	}
+#else
+#define PROBE_LANE_BITS 8
+
+static inline void probe_group(const uint16_t* ctrl, uint16_t first, uint64_t* match,
+                               uint64_t* stop)
+	{
+	static const uint16_t lanes[PROBE_GROUP] = {0, 1, 2, 3, 4, 5, 6, 7};
+	const uint16x8_t low = vdupq_n_u16(0xFF);
+	uint16x8_t words = vld1q_u16(ctrl);
+	uint16x8_t expected = vaddq_u16(vdupq_n_u16(first), vld1q_u16(lanes));
+	uint16x8_t eq = vceqq_u16(words, expected);
+	uint16x8_t lt = vcltq_u16(vandq_u16(words, low), vandq_u16(expected, low));
+	*match = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(eq)), 0);
+	*stop = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(lt)), 0);
+	}
+#endif
+#endif
+
 // Returns the position of the item if it exists. Otherwise returns -1, but set the insert
 // position/distance if required. The starting point for the search may not be the bucket
 // for the current table size since this method is also used to search for an item in the
@@ -1109,10 +1368,71 @@ int Dictionary::LookupIndex(const void* key, int key_size, detail::hash_t hash,
                             int* insert_position /*output*/, int* insert_distance /*output*/)
 	{
 	ASSERT(bucket >= 0 && bucket < Buckets());
+	uint16_t tag = control_word(hash, 0) & 0xFF00;
 	int i = bucket;
-	for ( ; i < end && ! table[i].Empty() && BucketByPosition(i) <= bucket; i++ )
-		if ( BucketByPosition(i) == bucket && table[i].Equal((char*)key, key_size, hash) )
+
+#ifdef PROBE_GROUP
+	// Compare whole groups of control words while they are all in range and
+	// no distance in them can be saturated.
+	while ( i + PROBE_GROUP <= end && i - bucket + PROBE_GROUP < 0xFF )
+		{
+		uint64_t match, stop;
+		probe_group(ctrl + i, tag | (i - bucket + 1), &match, &stop);
+
+		if ( stop )
+			// Only positions before the first stopping one are in the cluster.
+			match &= (uint64_t(1) << __builtin_ctzll(stop)) - 1;
+
+		while ( match )
+			{
+			int lane = __builtin_ctzll(match) / PROBE_LANE_BITS;
+			++num_key_comparisons;
+			if ( table[i + lane].Equal((char*)key, key_size, hash) )
+				return i + lane;
+
+			if ( lane == PROBE_GROUP - 1 )
+				break;
+
+			match &= ~((uint64_t(1) << ((lane + 1) * PROBE_LANE_BITS)) - 1);
+			}
+
+		if ( stop )
+			{
+			i += __builtin_ctzll(stop) / PROBE_LANE_BITS;
+			end = i;
+			break;
+			}
+
+		i += PROBE_GROUP;
+		}
+#endif
+
+	for ( ; i < end; i++ )
+		{
+		int distance = i - bucket;
+		uint16_t c = ctrl[i];
+
+		if ( (c & 0xFF) == 0xFF )
+			{
+			// Saturated, so the entry has to tell its distance.
+			if ( table[i].distance < distance )
+				break;
+			if ( table[i].distance != distance )
+				continue;
+			}
+		else
+			{
+			// Empty, or an entry of a later bucket.
+			if ( (c & 0xFF) <= distance )
+				break;
+			if ( c != (tag | (distance + 1)) )
+				continue;
+			}
+
+		++num_key_comparisons;
+		if ( table[i].Equal((char*)key, key_size, hash) )
 			return i;
+		}
 
 	// no such cluster, or not found in the cluster.
 	if ( insert_position )
@@ -1130,6 +1450,41 @@ int Dictionary::LookupIndex(const void* key, int key_size, detail::hash_t hash,
 	return -1;
 	}
 
+// Like the scalar part of LookupIndex(), but checks hashes and match()
+// instead of keys.
+int Dictionary::LookupIndexByHash(detail::hash_t hash,
+                                  const std::function<bool(const void*)>& match, int bucket,
+                                  int end) const
+	{
+	uint16_t tag = control_word(hash, 0) & 0xFF00;
+
+	for ( int i = bucket; i < end; i++ )
+		{
+		int distance = i - bucket;
+		uint16_t c = ctrl[i];
+
+		if ( (c & 0xFF) == 0xFF )
+			{
+			if ( table[i].distance < distance )
+				break;
+			if ( table[i].distance != distance )
+				continue;
+			}
+		else
+			{
+			if ( (c & 0xFF) <= distance )
+				break;
+			if ( c != (tag | (distance + 1)) )
+				continue;
+			}
+
+		if ( ((table[i].hash ^ hash) & detail::HASH_MASK) == 0 && match(table[i].value) )
+			return i;
+		}
+
+	return -1;
+	}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Insert
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1265,14 +1620,14 @@ void Dictionary::InsertAndRelocate(detail::DictEntry& entry, int insert_position
 			ASSERT(insert_position == Capacity());
 			SizeUp(); // copied all the items to new table. as it's just copying without remapping,
 			          // insert_position is now empty.
-			table[insert_position] = entry;
+			SetEntry(insert_position, entry);
 			if ( last_affected_position )
 				*last_affected_position = insert_position;
 			return;
 			}
 		if ( table[insert_position].Empty() )
 			{ // the condition to end the loop.
-			table[insert_position] = entry;
+			SetEntry(insert_position, entry);
 			if ( last_affected_position )
 				*last_affected_position = insert_position;
 			return;
@@ -1284,7 +1639,7 @@ void Dictionary::InsertAndRelocate(detail::DictEntry& entry, int insert_position
 		t.distance += next - insert_position;
 
 		// swap
-		table[insert_position] = entry;
+		SetEntry(insert_position, entry);
 		entry = t;
 		insert_position = next; // append to the end of the current cluster.
 		}
@@ -1332,6 +1687,8 @@ void Dictionary::SizeUp()
 	table = (detail::DictEntry*)realloc(table, capacity * sizeof(detail::DictEntry));
 	for ( int i = prev_capacity; i < capacity; i++ )
 		table[i].SetEmpty();
+	ctrl = (uint16_t*)realloc(ctrl, capacity * sizeof(uint16_t));
+	memset(ctrl + prev_capacity, 0, (capacity - prev_capacity) * sizeof(uint16_t));
 
 	// REmap from last to first in reverse order. SizeUp can be triggered by 2 conditions, one of
 	// which is that the last space in the table is occupied and there's nowhere to put new items.
@@ -1408,6 +1765,18 @@ detail::DictEntry Dictionary::RemoveRelocateAndAdjust(int position)
 	return entry;
 	}
 
+void Dictionary::SetEntry(int position, const detail::DictEntry& entry)
+	{
+	table[position] = entry;
+	ctrl[position] = control_word(entry.hash, entry.distance);
+	}
+
+void Dictionary::SetEmpty(int position)
+	{
+	table[position].SetEmpty();
+	ctrl[position] = 0;
+	}
+
 detail::DictEntry Dictionary::RemoveAndRelocate(int position, int* last_affected_position)
 	{
 	// fill the empty position with the tail of the cluster of position+1.
@@ -1421,14 +1790,15 @@ detail::DictEntry Dictionary::RemoveAndRelocate(int position, int* last_affected
 			{
 			// no next cluster to fill, or next position is empty or next position is already in
 			// perfect bucket.
-			table[position].SetEmpty();
+			SetEmpty(position);
 			if ( last_affected_position )
 				*last_affected_position = position;
 			return entry;
 			}
 		int next = TailOfClusterByPosition(position + 1);
-		table[position] = table[next];
-		table[position].distance -= next - position; // distance improved for the item.
+		detail::DictEntry moved = table[next];
+		moved.distance -= next - position; // distance improved for the item.
+		SetEntry(position, moved);
 		position = next;
 		}
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -264,6 +265,13 @@ public:
 	void* Lookup(const detail::HashKey* key) const;
 	void* Lookup(const void* key, int key_size, detail::hash_t h) const;
 
+	// Looks up an entry by its hash alone, for users that keep hashes
+	// rather than keys. Returns the value of the entry with that hash for
+	// which match() holds, or nullptr. If key isn't null, it's set to
+	// the entry's key.
+	void* LookupByHash(detail::hash_t h, const std::function<bool(const void*)>& match,
+	                   std::unique_ptr<detail::HashKey>* key = nullptr) const;
+
 	// Returns previous value, or 0 if none.
 	// If iterators_invalidated is supplied, its value is set to true
 	// if the removal may have invalidated any existing iterators.
@@ -301,6 +309,10 @@ public:
 	// Total number of entries ever.
 	uint64_t NumCumulativeInserts() const { return cum_entries; }
 
+	// Number of entries that lookups compared keys with, as their control
+	// words didn't rule them out.
+	uint64_t NumKeyComparisons() const { return num_key_comparisons; }
+
 	// True if the dictionary is ordered, false otherwise.
 	int IsOrdered() const { return order != nullptr; }
 
@@ -455,6 +467,8 @@ private:
 	                int* insert_position = nullptr, int* insert_distance = nullptr);
 	int LookupIndex(const void* key, int key_size, detail::hash_t hash, int begin, int end,
 	                int* insert_position = nullptr, int* insert_distance = nullptr);
+	int LookupIndexByHash(detail::hash_t hash, const std::function<bool(const void*)>& match,
+	                      int bucket, int end) const;
 
 	/// Insert entry, Adjust cookies when necessary.
 	void InsertRelocateAndAdjust(detail::DictEntry& entry, int insert_position);
@@ -497,6 +511,11 @@ private:
 
 	void SizeUp();
 
+	// Store an entry at a position of the table, or empty it, keeping the
+	// control words in sync.
+	void SetEntry(int position, const detail::DictEntry& entry);
+	void SetEmpty(int position);
+
 	bool HaveOnlyRobustIterators() const
 		{
 		return (num_iterators == 0) ||
@@ -529,9 +548,18 @@ private:
 	int num_entries = 0;
 	int max_entries = 0;
 	uint64_t cum_entries = 0;
+	uint64_t num_key_comparisons = 0;
 
 	dict_delete_func delete_func = nullptr;
 	detail::DictEntry* table = nullptr;
+
+	// One control word per table position, for probing without touching the
+	// entries: a tag taken from hash bits that don't select the bucket in the
+	// upper byte, the distance plus one in the lower byte (saturating at
+	// 0xFF), or zero if the position is empty. A cache line holds 32 of them,
+	// but fewer than three entries.
+	uint16_t* ctrl = nullptr;
+
 	std::vector<IterCookie*>* cookies = nullptr;
 	std::vector<RobustDictIterator*>* iterators = nullptr;
 
@@ -87,6 +87,27 @@ int EquivClass::BuildECs()
 	return num_ecs;
 	}
 
+void EquivClass::Restore(const int* classes)
+	{
+	num_ecs = 0;
+
+	for ( int i = 0; i < size; ++i )
+		{
+		equiv_class[i] = classes[i];
+		rep[i] = i;
+
+		for ( int j = 0; j < i; ++j )
+			if ( classes[j] == classes[i] )
+				{
+				rep[i] = j;
+				break;
+				}
+
+		if ( classes[i] >= num_ecs )
+			num_ecs = classes[i] + 1;
+		}
+	}
+
 void EquivClass::CCL_Use(CCL* ccl)
 	{
 	// Note that it doesn't matter whether or not the character class is
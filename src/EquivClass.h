@@ -24,6 +24,11 @@ public:
 
 	void ConvertCCL(CCL* ccl);
 
+	// Sets the classes directly, as returned by EquivClasses() of an
+	// earlier instance, instead of building them. Each class's first
+	// symbol becomes its representative.
+	void Restore(const int* classes);
+
 	bool IsRep(int sym) const { return rep[sym] == sym; }
 	int EquivRep(int sym) const { return rep[sym]; }
 	int SymEquivClass(int sym) const { return equiv_class[sym]; }
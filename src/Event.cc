@@ -4,15 +4,18 @@
 
 #include "zeek/zeek-config.h"
 
+#include "zeek/3rdparty/doctest.h"
 #include "zeek/Desc.h"
 #include "zeek/Func.h"
 #include "zeek/NetVar.h"
 #include "zeek/RunState.h"
+#include "zeek/Timer.h"
 #include "zeek/Trigger.h"
 #include "zeek/Val.h"
 #include "zeek/iosource/Manager.h"
 #include "zeek/iosource/PktSrc.h"
 #include "zeek/plugin/Manager.h"
+#include "zeek/telemetry/Manager.h"
 
 zeek::EventMgr zeek::event_mgr;
 zeek::EventMgr& mgr = zeek::event_mgr;
@@ -20,6 +23,69 @@ zeek::EventMgr& mgr = zeek::event_mgr;
 namespace zeek
 	{
 
+namespace
+	{
+
+struct EventMetrics
+	{
+	telemetry::IntCounter queued;
+	telemetry::IntCounter dispatched;
+	telemetry::DblGauge rate;
+	};
+
+// Returns nullptr until the telemetry manager exists, as events may get
+// queued before that.
+EventMetrics* metrics()
+	{
+	if ( ! telemetry_mgr )
+		return nullptr;
+
+	static EventMetrics m = {
+		telemetry_mgr->CounterSingleton("zeek", "events-queued", "Events queued"),
+		telemetry_mgr->CounterSingleton("zeek", "events-dispatched", "Events dispatched"),
+		telemetry_mgr->GaugeSingleton<double>("zeek", "event-dispatch-rate",
+	                                          "Events dispatched per second, over the last "
+	                                          "second of network time"),
+	};
+
+	return &m;
+	}
+
+// The memory of deleted events, for reuse by new ones. Never deleted, so
+// that events deleted during shutdown can still use it.
+std::vector<void*>& spare_events()
+	{
+	static auto spares = new std::vector<void*>;
+	return *spares;
+	}
+
+// Whether two events can be handled in the same run.
+bool same_run(const Event* a, const Event* b)
+	{
+	return a->Handler() == b->Handler() &&
+	       (a->Source() == util::detail::SOURCE_BROKER) ==
+	           (b->Source() == util::detail::SOURCE_BROKER);
+	}
+
+	} // namespace
+
+namespace detail
+	{
+
+class EventRateTimer final : public Timer
+	{
+public:
+	explicit EventRateTimer(double t) : Timer(t, TIMER_EVENT_RATE) { }
+
+	void Dispatch(double t, bool is_expire) override
+		{
+		if ( ! is_expire )
+			event_mgr.UpdateRate(t);
+		}
+	};
+
+	} // namespace detail
+
 Event::Event(EventHandlerPtr arg_handler, zeek::Args arg_args, util::detail::SourceID arg_src,
              analyzer::ID arg_aid, Obj* arg_obj)
 	: handler(arg_handler), args(std::move(arg_args)), src(arg_src), aid(arg_aid), obj(arg_obj),
@@ -44,6 +110,28 @@ void Event::Describe(ODesc* d) const
 		d->Add("(");
 	}
 
+void* Event::operator new(size_t size)
+	{
+	auto& spares = spare_events();
+
+	if ( size != sizeof(Event) || spares.empty() )
+		return ::operator new(size);
+
+	auto p = spares.back();
+	spares.pop_back();
+	return p;
+	}
+
+void Event::operator delete(void* p, size_t size)
+	{
+	auto& spares = spare_events();
+
+	if ( size != sizeof(Event) || spares.size() >= MAX_SPARE_EVENTS )
+		::operator delete(p);
+	else
+		spares.push_back(p);
+	}
+
 void Event::Dispatch(bool no_remote)
 	{
 	if ( src == util::detail::SOURCE_BROKER )
@@ -70,6 +158,12 @@ void Event::Dispatch(bool no_remote)
 		reporter->EndErrorHandler();
 	}
 
+void Event::RecycleArgs()
+	{
+	detail::recycle_args(std::move(args));
+	args.clear();
+	}
+
 EventMgr::EventMgr()
 	{
 	head = tail = nullptr;
@@ -122,6 +216,10 @@ void EventMgr::Dispatch(Event* event, bool no_remote)
 	{
 	current_src = event->Source();
 	event->Dispatch(no_remote);
+
+	if ( event->RefCnt() == 1 )
+		event->RecycleArgs();
+
 	Unref(event);
 	}
 
@@ -136,6 +234,10 @@ void EventMgr::Drain()
 
 	draining = true;
 
+	// Runs of events for the same handler, see below. Not a member, as
+	// handlers may drain the queue themselves.
+	std::vector<Event*> run;
+
 	// Past Bro versions drained as long as there events, including when
 	// a handler queued new events during its execution. This could lead
 	// to endless loops in case a handler kept triggering its own event.
@@ -153,9 +255,34 @@ void EventMgr::Drain()
 			{
 			Event* next = current->NextEvent();
 
+			if ( next && same_run(current, next) )
+				{
+				bool no_remote = current->Source() == util::detail::SOURCE_BROKER;
+
+				// Consecutive events for the same handler, as an
+				// analyzer raises them for one connection after
+				// another, get handled with one call into it.
+				run.clear();
+
+				do
+					{
+					run.push_back(current);
+					current = current->NextEvent();
+					} while ( current && same_run(run.front(), current) );
+
+				DispatchRun(run, no_remote);
+				continue;
+				}
+
 			current_src = current->Source();
 			current_aid = current->Analyzer();
 			current->Dispatch();
+
+			// Unless a plugin kept a reference, nobody's going to look
+			// at the arguments anymore.
+			if ( current->RefCnt() == 1 )
+				current->RecycleArgs();
+
 			Unref(current);
 
 			++event_mgr.num_events_dispatched;
@@ -163,6 +290,16 @@ void EventMgr::Drain()
 			}
 		}
 
+	UpdateMetrics();
+
+	if ( ! rate_timer_running && detail::timer_mgr && run_state::network_time > 0.0 )
+		{
+		rate_timer_running = true;
+		rate_time = run_state::network_time;
+		rate_dispatched = num_events_dispatched;
+		detail::timer_mgr->Add(new detail::EventRateTimer(rate_time + 1.0));
+		}
+
 	// Note: we might eventually need a general way to specify things to
 	// do after draining events.
 	draining = false;
@@ -172,6 +309,71 @@ void EventMgr::Drain()
 	detail::trigger_mgr->Process();
 	}
 
+void EventMgr::UpdateMetrics()
+	{
+	auto m = metrics();
+
+	if ( ! m )
+		return;
+
+	m->queued.Inc(num_events_queued - reported_queued);
+	m->dispatched.Inc(num_events_dispatched - reported_dispatched);
+	reported_queued = num_events_queued;
+	reported_dispatched = num_events_dispatched;
+	}
+
+void EventMgr::DispatchRun(const std::vector<Event*>& run, bool no_remote)
+	{
+	EventHandlerPtr handler = run.front()->handler;
+
+	if ( handler->ErrorHandler() )
+		reporter->BeginErrorHandler();
+
+	auto args_of = [this, &run](size_t i)
+	{
+		current_src = run[i]->Source();
+		current_aid = run[i]->Analyzer();
+		return &run[i]->args;
+	};
+
+	try
+		{
+		handler->CallRun(run.size(), args_of, no_remote);
+		}
+
+	catch ( InterpreterException& e )
+		{
+		// Already reported.
+		}
+
+	if ( handler->ErrorHandler() )
+		reporter->EndErrorHandler();
+
+	for ( auto event : run )
+		{
+		if ( event->obj )
+			Unref(event->obj);
+
+		if ( event->RefCnt() == 1 )
+			event->RecycleArgs();
+
+		Unref(event);
+		++num_events_dispatched;
+		}
+	}
+
+void EventMgr::UpdateRate(double t)
+	{
+	auto m = metrics();
+
+	if ( m && t > rate_time )
+		m->rate.Set((num_events_dispatched - rate_dispatched) / (t - rate_time));
+
+	rate_time = t;
+	rate_dispatched = num_events_dispatched;
+	detail::timer_mgr->Add(new detail::EventRateTimer(t + 1.0));
+	}
+
 void EventMgr::Describe(ODesc* d) const
 	{
 	int n = 0;
@@ -216,3 +418,35 @@ void EventMgr::InitPostScript()
 	}
 
 	} // namespace zeek
+
+TEST_SUITE_BEGIN("Event");
+
+TEST_CASE("event arguments for dead handlers")
+	{
+	zeek::EventHandler handler("test_unhandled_event");
+	zeek::EventHandlerPtr h(&handler);
+	int built = 0;
+
+	auto build_args = [&built]()
+	{
+		++built;
+		return zeek::Args{};
+	};
+
+	// No handler, so neither arguments nor event.
+	zeek::event_mgr.Enqueue(h, build_args);
+	CHECK(built == 0);
+	CHECK_FALSE(zeek::event_mgr.HasEvents());
+
+	// Would be raised, but got turned off.
+	handler.SetGenerateAlways();
+	CHECK(static_cast<bool>(h));
+	handler.SetEnable(false);
+	CHECK_FALSE(static_cast<bool>(h));
+
+	zeek::event_mgr.Enqueue(h, build_args);
+	CHECK(built == 0);
+	CHECK_FALSE(zeek::event_mgr.HasEvents());
+	}
+
+TEST_SUITE_END();
@@ -4,6 +4,7 @@
 
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include "zeek/Flare.h"
 #include "zeek/IntrusivePtr.h"
@@ -17,6 +18,11 @@ namespace zeek
 
 class EventMgr;
 
+namespace detail
+	{
+class EventRateTimer;
+	}
+
 class Event final : public Obj
 	{
 public:
@@ -34,13 +40,27 @@ public:
 
 	void Describe(ODesc* d) const override;
 
+	/**
+	 * Events get queued and dispatched all the time, so rather than
+	 * returning their memory, dispatched events keep it for reuse by new
+	 * ones, up to MAX_SPARE_EVENTS of them.
+	 */
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 protected:
 	friend class EventMgr;
 
-	// This method is protected to make sure that everybody goes through
+	static constexpr size_t MAX_SPARE_EVENTS = 4096;
+
+	// These methods are protected to make sure that everybody goes through
 	// EventMgr::Dispatch().
 	void Dispatch(bool no_remote = false);
 
+	// Releases the event's arguments once it's been dispatched, for
+	// reuse by new events.
+	void RecycleArgs();
+
 	EventHandlerPtr handler;
 	zeek::Args args;
 	util::detail::SourceID src;
@@ -78,7 +98,29 @@ public:
 	std::enable_if_t<std::is_convertible_v<std::tuple_element_t<0, std::tuple<Args...>>, ValPtr>>
 	Enqueue(const EventHandlerPtr& h, Args&&... args)
 		{
-		return Enqueue(h, zeek::Args{std::forward<Args>(args)...});
+		return Enqueue(h, detail::make_args(std::forward<Args>(args)...));
+		}
+
+	/**
+	 * A version of Enqueue() that calls *build_args* for the argument
+	 * list only if the event has a handler that's enabled, and otherwise
+	 * doesn't queue the event at all. This saves constructing arguments
+	 * that nobody would look at.
+	 * @param h  reference to the event handler to later call.
+	 * @param build_args  a callable returning the argument list.
+	 * @param src  indicates the origin of the event (local versus remote).
+	 * @param aid  identifies the protocol analyzer generating the event.
+	 * @param obj  an arbitrary object to use as a "cookie" or just hold a
+	 * reference to until dispatching the event.
+	 */
+	template <class F>
+	std::enable_if_t<std::is_invocable_r_v<zeek::Args, F>>
+	Enqueue(const EventHandlerPtr& h, F&& build_args,
+	        util::detail::SourceID src = util::detail::SOURCE_LOCAL, analyzer::ID aid = 0,
+	        Obj* obj = nullptr)
+		{
+		if ( h )
+			Enqueue(h, std::forward<F>(build_args)(), src, aid, obj);
 		}
 
 	void Dispatch(Event* event, bool no_remote = false);
@@ -99,6 +141,13 @@ public:
 
 	void Describe(ODesc* d) const override;
 
+	/**
+	 * Brings the event telemetry counters up to date: the number of events
+	 * queued and dispatched. The dispatch rate gets updated once a second
+	 * of network time.
+	 */
+	void UpdateMetrics();
+
 	double GetNextTimeout() override { return -1; }
 	void Process() override;
 	const char* Tag() override { return "EventManager"; }
@@ -108,8 +157,18 @@ public:
 	uint64_t num_events_dispatched = 0;
 
 protected:
+	friend class detail::EventRateTimer;
+
 	void QueueEvent(Event* event);
 
+	// Dispatches a run of consecutive events for the same handler with a
+	// single call into it, see Drain().
+	void DispatchRun(const std::vector<Event*>& run, bool no_remote);
+
+	// Sets the dispatch rate gauge from the events dispatched since the
+	// last update, as of network time t, and schedules the next one.
+	void UpdateRate(double t);
+
 	Event* head;
 	Event* tail;
 	util::detail::SourceID current_src;
@@ -117,6 +176,14 @@ protected:
 	RecordVal* src_val;
 	bool draining;
 	detail::Flare queue_flare;
+
+	// The totals UpdateMetrics() last reported, and the dispatched total
+	// and network time of the last rate update.
+	uint64_t reported_queued = 0;
+	uint64_t reported_dispatched = 0;
+	uint64_t rate_dispatched = 0;
+	double rate_time = 0.0;
+	bool rate_timer_running = false;
 	};
 
 extern EventMgr event_mgr;
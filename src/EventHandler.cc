@@ -107,6 +107,23 @@ void EventHandler::Call(Args* vl, bool no_remote)
 		local->Invoke(vl);
 	}
 
+void EventHandler::CallRun(size_t n, const std::function<zeek::Args*(size_t)>& args_of,
+                           bool no_remote)
+	{
+	if ( new_event || (! no_remote && ! auto_publish.empty()) || ! local ||
+	     local->GetKind() != Func::SCRIPT_FUNC )
+		{
+		// Something to do for each event besides running the bodies.
+		for ( size_t i = 0; i < n; ++i )
+			Call(args_of(i), no_remote);
+
+		return;
+		}
+
+	// No try/catch here either.
+	static_cast<detail::ScriptFunc*>(local.get())->InvokeEvents(n, args_of);
+	}
+
 void EventHandler::NewEvent(Args* vl)
 	{
 	if ( ! new_event )
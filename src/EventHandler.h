@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <unordered_set>
 
@@ -34,6 +35,12 @@ public:
 
 	void Call(zeek::Args* vl, bool no_remote = false);
 
+	// Calls the handler for a run of n queued events, in order, like
+	// Call() would one by one. args_of(i) returns the i-th event's
+	// arguments and gets called just before handling it.
+	void CallRun(size_t n, const std::function<zeek::Args*(size_t)>& args_of,
+	             bool no_remote = false);
+
 	// Returns true if there is at least one local or remote handler.
 	explicit operator bool() const;
 
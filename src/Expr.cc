@@ -1018,7 +1018,7 @@ ValPtr BinaryExpr::Fold(Val* v1, Val* v2) const
 	const auto& ret_type = IsVector(GetType()->Tag()) ? GetType()->Yield() : GetType();
 
 	if ( ret_type->Tag() == TYPE_INTERVAL )
-		return make_intrusive<IntervalVal>(d3);
+		return val_mgr->Interval(d3);
 	else if ( ret_type->Tag() == TYPE_TIME )
 		return make_intrusive<TimeVal>(d3);
 	else if ( ret_type->Tag() == TYPE_DOUBLE )
@@ -1455,7 +1455,7 @@ ValPtr NegExpr::Fold(Val* v) const
 	if ( v->GetType()->Tag() == TYPE_DOUBLE )
 		return make_intrusive<DoubleVal>(-v->InternalDouble());
 	else if ( v->GetType()->Tag() == TYPE_INTERVAL )
-		return make_intrusive<IntervalVal>(-v->InternalDouble());
+		return val_mgr->Interval(-v->InternalDouble());
 	else
 		return val_mgr->Int(-v->CoerceToInt());
 	}
@@ -4,6 +4,7 @@
 
 #include <broker/error.hh>
 
+#include "zeek/3rdparty/doctest.h"
 #include "zeek/Desc.h"
 #include "zeek/Func.h"
 #include "zeek/ID.h"
@@ -19,7 +20,7 @@ namespace zeek::detail
 Frame::Frame(int arg_size, const ScriptFunc* func, const zeek::Args* fn_args)
 	{
 	size = arg_size;
-	frame = std::make_unique<Element[]>(size);
+	frame = NewElements(size);
 	function = func;
 	func_args = fn_args;
 
@@ -61,6 +62,70 @@ Frame::~Frame()
 
 	for ( int i = 0; i < size; ++i )
 		ClearElement(i);
+
+	DeleteElements(frame, size);
+	}
+
+void* Frame::operator new(size_t size)
+	{
+	auto& spares = SpareFrames();
+
+	if ( size != sizeof(Frame) || spares.empty() )
+		return ::operator new(size);
+
+	auto p = spares.back();
+	spares.pop_back();
+	return p;
+	}
+
+void Frame::operator delete(void* p, size_t size)
+	{
+	auto& spares = SpareFrames();
+
+	if ( size != sizeof(Frame) || spares.size() >= MAX_SPARE_FRAMES )
+		::operator delete(p);
+	else
+		spares.push_back(p);
+	}
+
+Frame::Element* Frame::NewElements(int n)
+	{
+	if ( n > MAX_POOLED_SIZE || SpareElements(n).empty() )
+		return new Element[n]();
+
+	auto& spares = SpareElements(n);
+	auto elements = spares.back();
+	spares.pop_back();
+	return elements;
+	}
+
+void Frame::DeleteElements(Element* elements, int n)
+	{
+	if ( n > MAX_POOLED_SIZE || SpareElements(n).size() >= MAX_SPARE_FRAMES )
+		{
+		delete[] elements;
+		return;
+		}
+
+	// ClearElement() leaves the flag of weak references set.
+	for ( int i = 0; i < n; ++i )
+		elements[i].weak_ref = false;
+
+	SpareElements(n).push_back(elements);
+	}
+
+std::vector<Frame::Element*>& Frame::SpareElements(int n)
+	{
+	// Never deleted, so that frames deleted during shutdown can still
+	// use it.
+	static auto spares = new std::vector<Element*>[MAX_POOLED_SIZE + 1];
+	return spares[n];
+	}
+
+std::vector<void*>& Frame::SpareFrames()
+	{
+	static auto spares = new std::vector<void*>;
+	return *spares;
 	}
 
 void Frame::AddFunctionWithClosureRef(ScriptFunc* func)
@@ -740,3 +805,30 @@ Frame::UnserializeOffsetMap(const broker::vector& data)
 	}
 
 	}
+
+TEST_SUITE_BEGIN("Frame");
+
+TEST_CASE("frame pool")
+	{
+	using zeek::detail::Frame;
+
+	auto f1 = zeek::make_intrusive<Frame>(3, nullptr, nullptr);
+	f1->SetElement(0, zeek::make_intrusive<zeek::StringVal>("a"));
+	f1->SetElement(2, zeek::make_intrusive<zeek::StringVal>("b"));
+	auto p1 = f1.get();
+	f1 = nullptr;
+
+	// A new frame reuses the one just deleted, without its values.
+	auto f2 = zeek::make_intrusive<Frame>(3, nullptr, nullptr);
+	CHECK_EQ(f2.get(), p1);
+
+	for ( int i = 0; i < 3; ++i )
+		CHECK_EQ(f2->GetElement(i).get(), nullptr);
+
+	// Frames too large for pooling work the same.
+	auto f3 = zeek::make_intrusive<Frame>(1000, nullptr, nullptr);
+	f3->SetElement(999, zeek::make_intrusive<zeek::StringVal>("c"));
+	CHECK_EQ(f3->GetElement(999)->AsString()->Len(), 1);
+	}
+
+TEST_SUITE_END();
@@ -59,6 +59,14 @@ public:
 	 */
 	virtual ~Frame() override;
 
+	/**
+	 * Function calls create and delete frames all the time, so rather
+	 * than returning their memory, deleted frames keep it for reuse by
+	 * new ones, up to MAX_SPARE_FRAMES of them.
+	 */
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	/**
 	 * @param n the index to get.
 	 * @return the value at index *n* of the underlying array.
@@ -279,6 +287,11 @@ public:
 private:
 	using OffsetMap = std::unordered_map<std::string, int>;
 
+	// Frames with up to this many elements reuse the element arrays of
+	// deleted ones, keeping up to MAX_SPARE_FRAMES of each size.
+	static constexpr int MAX_POOLED_SIZE = 64;
+	static constexpr size_t MAX_SPARE_FRAMES = 64;
+
 	struct Element
 		{
 		ValPtr val;
@@ -289,6 +302,19 @@ private:
 
 	const ValPtr& GetElementByID(const ID* id) const;
 
+	/**
+	 * Returns an array of *n* empty elements, and takes one back
+	 * once its values have been cleared.
+	 */
+	static Element* NewElements(int n);
+	static void DeleteElements(Element* elements, int n);
+
+	/** The spare element arrays of size *n*. */
+	static std::vector<Element*>& SpareElements(int n);
+
+	/** The memory of deleted frames. */
+	static std::vector<void*>& SpareFrames();
+
 	/**
 	 * Sets the element at index *n* of the underlying array to *v*, but does
 	 * not take ownership of a reference count to it.  This method is used to
@@ -340,7 +366,7 @@ private:
 	bool delayed;
 
 	/** Associates ID's offsets with values. */
-	std::unique_ptr<Element[]> frame;
+	Element* frame;
 
 	/**
 	 * The offset we're currently using for references into the frame.
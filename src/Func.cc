@@ -385,6 +385,38 @@ ValPtr ScriptFunc::Invoke(zeek::Args* args, Frame* parent) const
 		return Flavor() == FUNC_FLAVOR_HOOK ? val_mgr->True() : nullptr;
 		}
 
+	return Execute(args, parent);
+	}
+
+void ScriptFunc::InvokeEvents(size_t n, const std::function<zeek::Args*(size_t)>& args_of) const
+	{
+	assert(Flavor() == FUNC_FLAVOR_EVENT);
+
+	if ( plugin_mgr && plugin_mgr->HavePluginForHook(plugin::HOOK_CALL_FUNCTION) )
+		{
+		// Plugins get to see, and maybe handle, each call.
+		for ( size_t i = 0; i < n; ++i )
+			Invoke(args_of(i), nullptr);
+
+		return;
+		}
+
+	for ( size_t i = 0; i < n; ++i )
+		{
+		auto args = args_of(i);
+
+		SegmentProfiler prof(segment_logger, location);
+
+		if ( sample_logger )
+			sample_logger->FunctionSeen(this);
+
+		if ( ! bodies.empty() )
+			Execute(args, nullptr);
+		}
+	}
+
+ValPtr ScriptFunc::Execute(zeek::Args* args, Frame* parent) const
+	{
 	auto f = make_intrusive<Frame>(frame_size, this, args);
 
 	if ( closure )
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -169,6 +170,17 @@ public:
 	bool IsPure() const override;
 	ValPtr Invoke(zeek::Args* args, Frame* parent) const override;
 
+	/**
+	 * Handles a run of queued events for this event handler, as Invoke()
+	 * would one after the other, but going through the checks that apply
+	 * to all of them just once.
+	 *
+	 * @param n  the number of events
+	 * @param args_of  returns the arguments of the i-th event, called
+	 * just before handling it
+	 */
+	void InvokeEvents(size_t n, const std::function<zeek::Args*(size_t)>& args_of) const;
+
 	/**
 	 * Creates a separate frame for captures and initializes its
 	 * elements.  The list of captures comes from the ScriptFunc's
@@ -303,6 +315,9 @@ protected:
 	virtual void SetCaptures(Frame* f);
 
 private:
+	// Runs the bodies, for Invoke() once it's clear that it has to.
+	ValPtr Execute(zeek::Args* args, Frame* parent) const;
+
 	size_t frame_size;
 
 	// List of the outer IDs used in the function.
@@ -7,7 +7,11 @@
 #include <highwayhash/highwayhash_target.h>
 #include <highwayhash/instruction_sets.h>
 #include <highwayhash/sip_hash.h>
+#include <chrono>
+#include <cstring>
+#include <vector>
 
+#include "zeek/3rdparty/doctest.h"
 #include "zeek/DebugLogger.h"
 #include "zeek/Desc.h"
 #include "zeek/Reporter.h"
@@ -33,6 +37,63 @@ static_assert(std::is_same<hash128_t, highwayhash::HHResult128>::value,
 static_assert(std::is_same<hash256_t, highwayhash::HHResult256>::value,
               "Highwayhash return values must match hash_x_t");
 
+// Helpers for FastHash64(), which follows wyhash.
+static constexpr uint64_t fast_hash_secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                                 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+// Multiplies a and b from their 32-bit halves, for targets without 128-bit
+// integers. Sets the low and high 64 bits of the product.
+static inline void fast_hash_mul_portable(uint64_t a, uint64_t b, uint64_t* lo, uint64_t* hi)
+	{
+	uint64_t a_lo = a & 0xffffffff;
+	uint64_t a_hi = a >> 32;
+	uint64_t b_lo = b & 0xffffffff;
+	uint64_t b_hi = b >> 32;
+
+	uint64_t ll = a_lo * b_lo;
+	uint64_t lh = a_lo * b_hi;
+	uint64_t hl = a_hi * b_lo;
+	uint64_t hh = a_hi * b_hi;
+
+	// Can't overflow: three terms below 2^32 each.
+	uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+
+	*lo = (mid << 32) | (ll & 0xffffffff);
+	*hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+	}
+
+static inline void fast_hash_mul(uint64_t a, uint64_t b, uint64_t* lo, uint64_t* hi)
+	{
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = static_cast<__uint128_t>(a) * b;
+	*lo = static_cast<uint64_t>(r);
+	*hi = static_cast<uint64_t>(r >> 64);
+#else
+	fast_hash_mul_portable(a, b, lo, hi);
+#endif
+	}
+
+static inline uint64_t fast_hash_mix(uint64_t a, uint64_t b)
+	{
+	uint64_t lo, hi;
+	fast_hash_mul(a, b, &lo, &hi);
+	return lo ^ hi;
+	}
+
+static inline uint64_t fast_hash_read64(const uint8_t* p)
+	{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+	}
+
+static inline uint64_t fast_hash_read32(const uint8_t* p)
+	{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+	}
+
 void KeyedHash::InitializeSeeds(const std::array<uint32_t, SEED_INIT_SIZE>& seed_data)
 	{
 	static_assert(std::is_same<decltype(KeyedHash::shared_siphash_key),
@@ -55,6 +116,7 @@ void KeyedHash::InitializeSeeds(const std::array<uint32_t, SEED_INIT_SIZE>& seed
 	calculate_digest(Hash_SHA256, (const u_char*)seed_data.data(), sizeof(seed_data) - 16,
 	                 reinterpret_cast<unsigned char*>(shared_highwayhash_key));
 	memcpy(shared_siphash_key, reinterpret_cast<const char*>(seed_data.data()) + 64, 16);
+	fast_hash_seed = fast_hash_mix(shared_highwayhash_key[0], shared_highwayhash_key[1]);
 
 	seeds_initialized = true;
 	}
@@ -82,6 +144,69 @@ void KeyedHash::Hash256(const void* bytes, uint64_t size, hash256_t* result)
 		shared_highwayhash_key, static_cast<const char*>(bytes), size, result);
 	}
 
+hash64_t KeyedHash::FastHash64(const void* bytes, uint64_t size)
+	{
+	const auto* p = static_cast<const uint8_t*>(bytes);
+	const uint64_t* s = fast_hash_secret;
+	uint64_t seed = fast_hash_seed ^ s[0];
+	uint64_t a, b;
+
+	if ( size <= 16 )
+		{
+		if ( size >= 4 )
+			{
+			// Two possibly overlapping reads from each end cover it all.
+			size_t mid = (size >> 3) << 2;
+			a = (fast_hash_read32(p) << 32) | fast_hash_read32(p + mid);
+			b = (fast_hash_read32(p + size - 4) << 32) | fast_hash_read32(p + size - 4 - mid);
+			}
+		else if ( size > 0 )
+			{
+			a = (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+			b = 0;
+			}
+		else
+			a = b = 0;
+		}
+	else
+		{
+		size_t i = size;
+
+		if ( i > 48 )
+			{
+			uint64_t seed1 = seed;
+			uint64_t seed2 = seed;
+
+			do
+				{
+				seed = fast_hash_mix(fast_hash_read64(p) ^ s[1], fast_hash_read64(p + 8) ^ seed);
+				seed1 = fast_hash_mix(fast_hash_read64(p + 16) ^ s[2],
+				                      fast_hash_read64(p + 24) ^ seed1);
+				seed2 = fast_hash_mix(fast_hash_read64(p + 32) ^ s[3],
+				                      fast_hash_read64(p + 40) ^ seed2);
+				p += 48;
+				i -= 48;
+				} while ( i > 48 );
+
+			seed ^= seed1 ^ seed2;
+			}
+
+		while ( i > 16 )
+			{
+			seed = fast_hash_mix(fast_hash_read64(p) ^ s[1], fast_hash_read64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+			}
+
+		a = fast_hash_read64(p + i - 16);
+		b = fast_hash_read64(p + i - 8);
+		}
+
+	uint64_t lo, hi;
+	fast_hash_mul(a ^ s[1], b ^ seed, &lo, &hi);
+	return fast_hash_mix(lo ^ s[0] ^ size, hi ^ s[1]);
+	}
+
 hash64_t KeyedHash::StaticHash64(const void* bytes, uint64_t size)
 	{
 	hash64_t result = 0;
@@ -543,4 +668,91 @@ void HashKey::EnsureReadSpace(size_t n) const
 		                        n, size - read_size);
 	}
 
+TEST_SUITE_BEGIN("Hash");
+
+TEST_CASE("fast hash")
+	{
+	unsigned char buf[128];
+	for ( size_t i = 0; i < sizeof(buf); ++i )
+		buf[i] = i;
+
+	// Every length hashes all of its bytes, and only those.
+	for ( size_t n = 1; n <= 100; ++n )
+		{
+		hash64_t h = KeyedHash::FastHash64(buf, n);
+		CHECK(h == KeyedHash::FastHash64(buf, n));
+		CHECK(h != KeyedHash::FastHash64(buf, n - 1));
+
+		buf[n - 1] ^= 1;
+		CHECK(h != KeyedHash::FastHash64(buf, n));
+		buf[n - 1] ^= 1;
+
+		buf[n] ^= 1;
+		CHECK(h == KeyedHash::FastHash64(buf, n));
+		buf[n] ^= 1;
+		}
+	}
+
+TEST_CASE("fast hash portable multiply")
+	{
+	uint64_t lo, hi;
+
+	fast_hash_mul_portable(0xffffffffffffffffull, 0xffffffffffffffffull, &lo, &hi);
+	CHECK(lo == 1);
+	CHECK(hi == 0xfffffffffffffffeull);
+
+	fast_hash_mul_portable(0x100000000ull, 0x100000000ull, &lo, &hi);
+	CHECK(lo == 0);
+	CHECK(hi == 1);
+
+	// Agrees with the multiplication used on this target.
+	uint64_t a = fast_hash_secret[0];
+	uint64_t b = fast_hash_secret[1];
+
+	for ( int i = 0; i < 1000; ++i )
+		{
+		uint64_t native_lo, native_hi;
+		fast_hash_mul(a, b, &native_lo, &native_hi);
+		fast_hash_mul_portable(a, b, &lo, &hi);
+		CHECK(lo == native_lo);
+		CHECK(hi == native_hi);
+
+		a = fast_hash_mix(a, fast_hash_secret[2]);
+		b = fast_hash_mix(b, fast_hash_secret[3]) + i;
+		}
+	}
+
+TEST_CASE("hash benchmark" * doctest::skip())
+	{
+	// Compares the table key hashes for the key sizes typical of tables:
+	// counts, addresses, [addr, port] and connection-ID-like keys. Run with
+	// "zeek --test -tc='hash benchmark' -ns".
+	const int rounds = 10000000;
+	std::vector<unsigned char> buf(64);
+
+	auto time = [&](const char* what, size_t size, auto f)
+		{
+		hash64_t sum = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < rounds; ++i )
+			{
+			buf[i % size] = i;
+			sum += f(buf.data(), size);
+			}
+
+		std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+		MESSAGE(what << ", " << size << " bytes: " << secs.count() * 1e9 / rounds
+		             << " ns per hash (" << sum % 10 << ")");
+		};
+
+	for ( size_t size : {4, 8, 16, 24, 32, 40} )
+		{
+		time("Hash64", size, KeyedHash::Hash64);
+		time("FastHash64", size, KeyedHash::FastHash64);
+		}
+	}
+
+TEST_SUITE_END();
+
 	} // namespace zeek::detail
@@ -5,6 +5,7 @@
 #include "zeek/zeek-config.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "zeek/Desc.h"
 #include "zeek/EquivClass.h"
@@ -13,7 +14,8 @@
 namespace zeek::detail
 	{
 
-static int nfa_state_id = 0;
+// Unique across all threads that build NFAs.
+static std::atomic<int> nfa_state_id = 0;
 
 NFA_State::NFA_State(int arg_sym, EquivClass* ec)
 	{
@@ -335,8 +337,9 @@ NFA_Machine* make_alternate(NFA_Machine* m1, NFA_Machine* m2)
 
 NFA_state_list* epsilon_closure(NFA_state_list* states)
 	{
-	// We just keep one of this as it may get quite large.
-	static IntSet closuremap;
+	// We just keep one of this as it may get quite large. It's per
+	// thread as separate DFAs may get computed in parallel.
+	thread_local IntSet closuremap;
 	closuremap.Clear();
 
 	NFA_state_list* closure = new NFA_state_list;
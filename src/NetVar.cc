@@ -171,6 +171,7 @@ int other_addr_anonymization;
 double profiling_interval;
 int expensive_profiling_multiple;
 int segment_profiling;
+int analyzer_profiling;
 int pkt_profile_mode;
 double pkt_profile_freq;
 
@@ -179,10 +180,18 @@ int load_sample_freq;
 int packet_filter_default;
 
 int sig_max_group_size;
+int sig_literal_prefilter;
+bro_uint_t dfa_max_state_memory;
+int sig_precompute_dfa_states;
+int pattern_compile_threads;
+int sig_prefix_cache_size;
+int sig_file_magic_index;
+int sig_profile_sample_interval;
 
 int dpd_reassemble_first_packets;
 int dpd_buffer_size;
 int dpd_max_packets;
+bro_uint_t dpd_max_total_buffer_size;
 int dpd_match_only_beginning;
 int dpd_late_match_stop;
 int dpd_ignore_ports;
@@ -242,6 +251,13 @@ void init_general_global_var()
 	table_incremental_step = id::find_val("table_incremental_step")->AsCount();
 	packet_filter_default = id::find_val("packet_filter_default")->AsBool();
 	sig_max_group_size = id::find_val("sig_max_group_size")->AsCount();
+	sig_literal_prefilter = id::find_val("sig_literal_prefilter")->AsBool();
+	dfa_max_state_memory = id::find_val("dfa_max_state_memory")->AsCount();
+	sig_precompute_dfa_states = id::find_val("sig_precompute_dfa_states")->AsCount();
+	pattern_compile_threads = id::find_val("pattern_compile_threads")->AsCount();
+	sig_prefix_cache_size = id::find_val("sig_prefix_cache_size")->AsCount();
+	sig_file_magic_index = id::find_val("sig_file_magic_index")->AsBool();
+	sig_profile_sample_interval = id::find_val("sig_profile_sample_interval")->AsCount();
 	check_for_unused_event_handlers = id::find_val("check_for_unused_event_handlers")->AsBool();
 	record_all_packets = id::find_val("record_all_packets")->AsBool();
 	bits_per_uid = id::find_val("bits_per_uid")->AsCount();
@@ -333,6 +349,7 @@ void init_net_var()
 	expensive_profiling_multiple = id::find_val("expensive_profiling_multiple")->AsCount();
 	profiling_interval = id::find_val("profiling_interval")->AsInterval();
 	segment_profiling = id::find_val("segment_profiling")->AsBool();
+	analyzer_profiling = id::find_val("analyzer_profiling")->AsBool();
 
 	pkt_profile_mode = id::find_val("pkt_profile_mode")->InternalInt();
 	pkt_profile_freq = id::find_val("pkt_profile_freq")->AsDouble();
@@ -342,6 +359,7 @@ void init_net_var()
 	dpd_reassemble_first_packets = id::find_val("dpd_reassemble_first_packets")->AsBool();
 	dpd_buffer_size = id::find_val("dpd_buffer_size")->AsCount();
 	dpd_max_packets = id::find_val("dpd_max_packets")->AsCount();
+	dpd_max_total_buffer_size = id::find_val("dpd_max_total_buffer_size")->AsCount();
 	dpd_match_only_beginning = id::find_val("dpd_match_only_beginning")->AsBool();
 	dpd_late_match_stop = id::find_val("dpd_late_match_stop")->AsBool();
 	dpd_ignore_ports = id::find_val("dpd_ignore_ports")->AsBool();
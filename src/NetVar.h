@@ -73,6 +73,7 @@ extern double profiling_interval;
 extern int expensive_profiling_multiple;
 
 extern int segment_profiling;
+extern int analyzer_profiling;
 extern int pkt_profile_mode;
 extern double pkt_profile_freq;
 extern int load_sample_freq;
@@ -80,10 +81,18 @@ extern int load_sample_freq;
 extern int packet_filter_default;
 
 extern int sig_max_group_size;
+extern int sig_literal_prefilter;
+extern bro_uint_t dfa_max_state_memory;
+extern int sig_precompute_dfa_states;
+extern int pattern_compile_threads;
+extern int sig_prefix_cache_size;
+extern int sig_file_magic_index;
+extern int sig_profile_sample_interval;
 
 extern int dpd_reassemble_first_packets;
 extern int dpd_buffer_size;
 extern int dpd_max_packets;
+extern bro_uint_t dpd_max_total_buffer_size;
 extern int dpd_match_only_beginning;
 extern int dpd_late_match_stop;
 extern int dpd_ignore_ports;
@@ -9,6 +9,7 @@
 #include "zeek/CompHash.h"
 #include "zeek/Desc.h"
 #include "zeek/NetVar.h"
+#include "zeek/RE.h"
 #include "zeek/Reporter.h"
 #include "zeek/Scope.h"
 #include "zeek/Var.h"
@@ -1001,6 +1002,92 @@ ValPtr ParaglobVal::DoClone(CloneState* state)
 		}
 	}
 
+PatternSetVal::PatternSetVal() : OpaqueVal(pattern_set_type) { }
+
+PatternSetVal::PatternSetVal(std::vector<std::string> arg_patterns)
+	: OpaqueVal(pattern_set_type), patterns(std::move(arg_patterns))
+	{
+	Compile();
+	}
+
+PatternSetVal::~PatternSetVal() = default;
+
+bool PatternSetVal::Compile()
+	{
+	detail::string_list exprs;
+	detail::int_list ids;
+
+	for ( size_t i = 0; i < patterns.size(); ++i )
+		{
+		exprs.push_back(const_cast<char*>(patterns[i].c_str()));
+		ids.push_back(i + 1);
+		}
+
+	auto m = std::make_unique<detail::Specific_RE_Matcher>(detail::MATCH_EXACTLY);
+
+	if ( ! m->CompileSet(exprs, ids) )
+		{
+		matcher.reset();
+		return false;
+		}
+
+	matcher = std::move(m);
+	return true;
+	}
+
+VectorValPtr PatternSetVal::Match(const StringVal* s) const
+	{
+	auto rval = make_intrusive<VectorVal>(id::index_vec);
+
+	if ( ! matcher )
+		return rval;
+
+	std::vector<detail::AcceptIdx> matches;
+	matcher->MatchSet(s->AsString(), matches);
+
+	for ( auto idx : matches )
+		rval->Assign(rval->Size(), val_mgr->Count(idx - 1));
+
+	return rval;
+	}
+
+ValPtr PatternSetVal::DoClone(CloneState* state)
+	{
+	return state->NewClone(this, make_intrusive<PatternSetVal>(patterns));
+	}
+
+IMPLEMENT_OPAQUE_VALUE(PatternSetVal)
+
+broker::expected<broker::data> PatternSetVal::DoSerialize() const
+	{
+	broker::vector d;
+
+	for ( const auto& p : patterns )
+		d.emplace_back(p);
+
+	return {std::move(d)};
+	}
+
+bool PatternSetVal::DoUnserialize(const broker::data& data)
+	{
+	auto d = caf::get_if<broker::vector>(&data);
+	if ( ! d )
+		return false;
+
+	patterns.clear();
+
+	for ( const auto& p : *d )
+		{
+		auto s = caf::get_if<std::string>(&p);
+		if ( ! s )
+			return false;
+
+		patterns.emplace_back(*s);
+		}
+
+	return Compile();
+	}
+
 broker::expected<broker::data> TelemetryVal::DoSerialize() const
 	{
 	return broker::make_error(broker::ec::invalid_data, "cannot serialize metric handles");
@@ -30,6 +30,10 @@ namespace probabilistic::detail
 	{
 class CardinalityCounter;
 	}
+namespace detail
+	{
+class Specific_RE_Matcher;
+	}
 
 class OpaqueVal;
 using OpaqueValPtr = IntrusivePtr<OpaqueVal>;
@@ -392,6 +396,45 @@ private:
 	std::unique_ptr<paraglob::Paraglob> internal_paraglob;
 	};
 
+/**
+ * A set of patterns compiled into a single DFA, so that a string can be
+ * matched against all of them in one pass.
+ */
+class PatternSetVal : public OpaqueVal
+	{
+public:
+	/**
+	 * Compiles the given patterns into a set.
+	 * @param patterns  the "anywhere" texts of the patterns, as returned
+	 * by RE_Matcher::AnywherePatternText().
+	 */
+	explicit PatternSetVal(std::vector<std::string> patterns);
+	~PatternSetVal() override;
+
+	/**
+	 * @return false if the patterns failed to compile.
+	 */
+	bool IsValid() const { return matcher != nullptr; }
+
+	/**
+	 * Returns the (zero-based) indices of all patterns found in s.
+	 */
+	VectorValPtr Match(const StringVal* s) const;
+
+	ValPtr DoClone(CloneState* state) override;
+
+protected:
+	PatternSetVal();
+
+	DECLARE_OPAQUE_VALUE(PatternSetVal)
+
+private:
+	bool Compile();
+
+	std::vector<std::string> patterns;
+	std::unique_ptr<detail::Specific_RE_Matcher> matcher;
+	};
+
 /**
  * Base class for metric handles. Handle types are not serializable.
  */
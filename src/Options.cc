@@ -17,6 +17,7 @@
 #include <cstdlib>
 #include <sstream>
 
+#include "zeek/Val.h"
 #include "zeek/bsd-getopt-long.h"
 #include "zeek/logging/writers/ascii/Ascii.h"
 
@@ -165,6 +166,10 @@ void usage(const char* prog, int code)
 	        getenv("ZEEK_DNS_RESOLVER")
 	            ? getenv("ZEEK_DNS_RESOLVER")
 	            : "not set, will use first IPv4 address from /etc/resolv.conf");
+	fprintf(stderr, "    $ZEEK_VAL_CACHE_MAX_COUNT      | largest preallocated count value (%llu)\n",
+	        static_cast<unsigned long long>(ValManager::PREALLOCATED_COUNTS - 1));
+	fprintf(stderr, "    $ZEEK_VAL_CACHE_MAX_INT        | largest preallocated int value (%lld)\n",
+	        static_cast<long long>(ValManager::PREALLOCATED_INT_HIGHEST));
 	fprintf(
 		stderr,
 		"    $ZEEK_DEBUG_LOG_STDERR         | Use stderr for debug logs generated via the -B flag");
@@ -5,13 +5,19 @@
 #include "zeek/zeek-config.h"
 
 #include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <unordered_set>
 #include <utility>
 
+#include "zeek/3rdparty/doctest.h"
 #include "zeek/CCL.h"
 #include "zeek/DFA.h"
 #include "zeek/EquivClass.h"
 #include "zeek/Reporter.h"
 #include "zeek/ZeekString.h"
+#include "zeek/util.h"
 
 zeek::detail::CCL* zeek::detail::curr_ccl = nullptr;
 zeek::detail::Specific_RE_Matcher* zeek::detail::rem = nullptr;
@@ -27,6 +33,9 @@ namespace zeek
 namespace detail
 	{
 
+// Matchers compiled lazily that build_pending_dfas() hasn't gotten to yet.
+static std::unordered_set<Specific_RE_Matcher*> pending_matchers;
+
 Specific_RE_Matcher::Specific_RE_Matcher(match_type arg_mt, int arg_multiline)
 	: equiv_class(NUM_SYM)
 	{
@@ -35,6 +44,7 @@ Specific_RE_Matcher::Specific_RE_Matcher(match_type arg_mt, int arg_multiline)
 	any_ccl = nullptr;
 	pattern_text = nullptr;
 	dfa = nullptr;
+	pending_nfa = nullptr;
 	ecs = nullptr;
 	accepted = new AcceptingSet();
 	}
@@ -44,6 +54,12 @@ Specific_RE_Matcher::~Specific_RE_Matcher()
 	for ( int i = 0; i < ccl_list.length(); ++i )
 		delete ccl_list[i];
 
+	if ( pending_nfa )
+		{
+		pending_matchers.erase(this);
+		Unref(pending_nfa);
+		}
+
 	Unref(dfa);
 	delete[] pattern_text;
 	delete accepted;
@@ -139,20 +155,18 @@ bool Specific_RE_Matcher::Compile(bool lazy)
 		return false;
 		}
 
-	EC()->BuildECs();
-	ConvertCCLs();
-
-	dfa = new DFA_Machine(nfa, EC());
-
-	Unref(nfa);
+	pending_nfa = nfa;
 	nfa = nullptr;
 
-	ecs = EC()->EquivClasses();
+	if ( lazy )
+		pending_matchers.insert(this);
+	else
+		BuildDFA();
 
 	return true;
 	}
 
-bool Specific_RE_Matcher::CompileSet(const string_list& set, const int_list& idx)
+bool Specific_RE_Matcher::CompileSet(const string_list& set, const int_list& idx, bool lazy)
 	{
 	if ( (size_t)set.length() != idx.size() )
 		reporter->InternalError("compileset: lengths of sets differ");
@@ -185,20 +199,56 @@ bool Specific_RE_Matcher::CompileSet(const string_list& set, const int_list& idx
 		}
 
 	// Prefix the expression with a "^?".
-	nfa = new NFA_Machine(new NFA_State(SYM_BOL, rem->EC()));
-	nfa->MakeOptional();
+	pending_nfa = new NFA_Machine(new NFA_State(SYM_BOL, EC()));
+	pending_nfa->MakeOptional();
 	if ( set_nfa )
-		nfa->AppendMachine(set_nfa);
+		pending_nfa->AppendMachine(set_nfa);
+
+	nfa = nullptr;
+
+	if ( ! lazy )
+		BuildDFA();
+
+	return true;
+	}
+
+void Specific_RE_Matcher::BuildDFA()
+	{
+	if ( ! pending_nfa )
+		return;
 
 	EC()->BuildECs();
 	ConvertCCLs();
 
-	dfa = new DFA_Machine(nfa, EC());
+	dfa = new DFA_Machine(pending_nfa, EC());
 	ecs = EC()->EquivClasses();
 
+	Unref(pending_nfa);
+	pending_nfa = nullptr;
+	}
+
+void Specific_RE_Matcher::BuildLazyDFA()
+	{
+	pending_matchers.erase(this);
+	BuildDFA();
+	}
+
+bool Specific_RE_Matcher::LoadSet(const std::string& path, const std::string& key)
+	{
+	dfa = DFA_Machine::Load(path, key, EC());
+
+	if ( ! dfa )
+		return false;
+
+	ecs = EC()->EquivClasses();
 	return true;
 	}
 
+bool Specific_RE_Matcher::SaveSet(const std::string& path, const std::string& key)
+	{
+	return dfa && dfa->Save(path, key);
+	}
+
 std::string Specific_RE_Matcher::LookupDef(const std::string& def)
 	{
 	const auto& iter = defs.find(def);
@@ -241,11 +291,16 @@ int Specific_RE_Matcher::LongestMatch(const String* s)
 
 bool Specific_RE_Matcher::MatchAll(const u_char* bv, int n)
 	{
+	if ( pending_nfa )
+		BuildLazyDFA();
+
 	if ( ! dfa )
 		// An empty pattern matches "all" iff what's being
 		// matched is empty.
 		return n == 0;
 
+	dfa->Prune();
+
 	DFA_State* d = dfa->StartState();
 	d = d->Xtion(ecs[SYM_BOL], dfa);
 
@@ -266,10 +321,15 @@ bool Specific_RE_Matcher::MatchAll(const u_char* bv, int n)
 
 int Specific_RE_Matcher::Match(const u_char* bv, int n)
 	{
+	if ( pending_nfa )
+		BuildLazyDFA();
+
 	if ( ! dfa )
 		// An empty pattern matches anything.
 		return 1;
 
+	dfa->Prune();
+
 	DFA_State* d = dfa->StartState();
 
 	d = d->Xtion(ecs[SYM_BOL], dfa);
@@ -297,9 +357,18 @@ int Specific_RE_Matcher::Match(const u_char* bv, int n)
 	return 0;
 	}
 
+void Specific_RE_Matcher::MatchSet(const String* s, std::vector<AcceptIdx>& matches)
+	{
+	RE_Match_State state(this);
+	state.Match(s->Bytes(), s->Len(), true, true, false);
+
+	for ( const auto& [idx, pos] : state.AcceptedMatches() )
+		matches.push_back(idx);
+	}
+
 void Specific_RE_Matcher::Dump(FILE* f)
 	{
-	dfa->Dump(f);
+	DFA()->Dump(f);
 	}
 
 inline void RE_Match_State::AddMatches(const AcceptingSet& as, MatchPos position)
@@ -307,11 +376,102 @@ inline void RE_Match_State::AddMatches(const AcceptingSet& as, MatchPos position
 	using am_idx = std::pair<AcceptIdx, MatchPos>;
 
 	for ( AcceptingSet::const_iterator it = as.begin(); it != as.end(); ++it )
-		accepted_matches.insert(am_idx(*it, position));
+		accepted_matches.insert(am_idx(*it, offset + position));
+	}
+
+RE_Match_State::~RE_Match_State()
+	{
+	Unref(pinned_state);
+	}
+
+void RE_Match_State::Clear()
+	{
+	current_pos = -1;
+	offset = 0;
+	current_state = nullptr;
+	Pin(nullptr);
+	accepted_matches.clear();
+	}
+
+void RE_Match_State::Pin(DFA_State* state)
+	{
+	if ( state == pinned_state )
+		return;
+
+	if ( state )
+		Ref(state);
+
+	Unref(pinned_state);
+	pinned_state = state;
+	}
+
+inline bool RE_Match_State::Step(int ec)
+	{
+	DFA_State* next_state = current_state->Xtion(ec, dfa);
+
+	if ( ! next_state )
+		{
+		current_state = nullptr;
+		return false;
+		}
+
+	const AcceptingSet* ac = next_state->Accept();
+
+	if ( ac )
+		AddMatches(*ac, current_pos);
+
+	++current_pos;
+
+	current_state = next_state;
+	return true;
+	}
+
+void RE_Match_State::MatchDense(const DFA_DenseTable* dense, const u_char* bv, int n)
+	{
+	const u_char* end = bv + n;
+
+	while ( bv < end )
+		{
+		int s = current_state->DenseIndex();
+
+		if ( s < 0 )
+			{
+			// Not in the table (yet).
+			if ( ! Step(ecs[*bv++]) )
+				return;
+
+			continue;
+			}
+
+		// Stay on the table for as long as it knows the transitions.
+		while ( bv < end )
+			{
+			uint16_t next = dense->Next(s, ecs[*bv]);
+
+			if ( next >= DFA_DenseTable::JAM )
+				break;
+
+			if ( dense->Accepting(next) )
+				AddMatches(*dense->State(next)->Accept(), current_pos);
+
+			++current_pos;
+			++bv;
+			s = next;
+			}
+
+		current_state = dense->State(s);
+
+		// Jams and unknown transitions go through the DFA_State.
+		if ( bv < end && ! Step(ecs[*bv++]) )
+			return;
+		}
 	}
 
 bool RE_Match_State::Match(const u_char* bv, int n, bool bol, bool eol, bool clear)
 	{
+	if ( dfa )
+		dfa->Prune();
+
 	if ( current_pos == -1 )
 		{
 		// First call to Match().
@@ -338,46 +498,72 @@ bool RE_Match_State::Match(const u_char* bv, int n, bool bol, bool eol, bool cle
 
 	size_t old_matches = accepted_matches.size();
 
-	int ec;
-	int m = bol ? n + 1 : n;
-	int e = eol ? -1 : 0;
+	if ( ! bol || Step(ecs[SYM_BOL]) )
+		Feed(bv, n, eol);
 
-	while ( --m >= e )
-		{
-		if ( m == n )
-			ec = ecs[SYM_BOL];
-		else if ( m == -1 )
-			ec = ecs[SYM_EOL];
-		else
-			ec = ecs[*(bv++)];
+	if ( current_state )
+		dfa->Cache()->Touch(current_state);
 
-		DFA_State* next_state = current_state->Xtion(ec, dfa);
+	Pin(current_state);
 
-		if ( ! next_state )
-			{
-			current_state = nullptr;
-			break;
-			}
+	return accepted_matches.size() != old_matches;
+	}
+
+bool RE_Match_State::MatchMore(const u_char* bv, int n, bool eol)
+	{
+	if ( ! current_state )
+		return false;
 
-		const AcceptingSet* ac = next_state->Accept();
+	dfa->Prune();
 
-		if ( ac )
-			AddMatches(*ac, current_pos);
+	size_t old_matches = accepted_matches.size();
 
-		++current_pos;
+	Feed(bv, n, eol);
 
-		current_state = next_state;
-		}
+	if ( current_state )
+		dfa->Cache()->Touch(current_state);
+
+	Pin(current_state);
 
 	return accepted_matches.size() != old_matches;
 	}
 
+void RE_Match_State::Restore(DFA_State* state, const AcceptingMatchSet& matches, int pos)
+	{
+	current_state = state;
+	current_pos = pos;
+	accepted_matches = matches;
+	Pin(state);
+	}
+
+void RE_Match_State::Feed(const u_char* bv, int n, bool eol)
+	{
+	const DFA_DenseTable* dense = dfa->Dense();
+
+	if ( dense )
+		MatchDense(dense, bv, n);
+	else
+		{
+		for ( int i = 0; i < n; ++i )
+			if ( ! Step(ecs[bv[i]]) )
+				break;
+		}
+
+	if ( eol && current_state )
+		Step(ecs[SYM_EOL]);
+	}
+
 int Specific_RE_Matcher::LongestMatch(const u_char* bv, int n)
 	{
+	if ( pending_nfa )
+		BuildLazyDFA();
+
 	if ( ! dfa )
 		// An empty pattern matches anything.
 		return 0;
 
+	dfa->Prune();
+
 	// Use -1 to indicate no match.
 	int last_accept = -1;
 	DFA_State* d = dfa->StartState();
@@ -480,6 +666,15 @@ RE_Matcher* RE_Matcher_disjunction(const RE_Matcher* re1, const RE_Matcher* re2)
 	return matcher_merge(re1, re2, "|");
 	}
 
+void build_pending_dfas(size_t num_threads)
+	{
+	std::vector<Specific_RE_Matcher*> matchers(pending_matchers.begin(), pending_matchers.end());
+	pending_matchers.clear();
+
+	util::detail::parallel_for(matchers.size(), num_threads,
+	                           [&matchers](size_t i) { matchers[i]->BuildDFA(); });
+	}
+
 	} // namespace detail
 
 RE_Matcher::RE_Matcher()
@@ -530,3 +725,382 @@ bool RE_Matcher::Compile(bool lazy)
 	}
 
 	} // namespace zeek
+
+TEST_SUITE_BEGIN("RE");
+
+namespace
+	{
+
+using namespace zeek::detail;
+
+const char* test_patterns[] = {".*GET /", ".*[Uu]ser-[Aa]gent: [a-z]+\\/[0-9]", "^HTTP\\/1\\.[01] ",
+                               ".*\\r\\n\\r\\n"};
+
+const char* test_payload = "GET /index.html HTTP/1.1\r\nHost: www.example.com\r\n"
+                           "User-Agent: curl/7.68.0\r\nAccept: */*\r\n\r\n";
+
+Specific_RE_Matcher* make_test_set(bool lazy = false)
+	{
+	auto m = new Specific_RE_Matcher(MATCH_EXACTLY, 1);
+	string_list exprs;
+	int_list ids;
+
+	for ( size_t i = 0; i < sizeof(test_patterns) / sizeof(test_patterns[0]); ++i )
+		{
+		exprs.push_back(const_cast<char*>(test_patterns[i]));
+		ids.push_back(i + 1);
+		}
+
+	m->CompileSet(exprs, ids, lazy);
+	return m;
+	}
+
+// Feeds the payload in chunks of the given size, returning the accepted
+// pattern indices.
+std::set<AcceptIdx> match_in_chunks(Specific_RE_Matcher* m, const std::string& payload,
+                                    size_t chunk)
+	{
+	RE_Match_State state(m);
+	std::set<AcceptIdx> rval;
+
+	for ( size_t i = 0; i < payload.size(); i += chunk )
+		{
+		auto n = std::min(chunk, payload.size() - i);
+		state.Match(reinterpret_cast<const u_char*>(payload.data() + i), n, i == 0,
+		            i + n == payload.size(), false);
+		}
+
+	for ( const auto& [idx, pos] : state.AcceptedMatches() )
+		rval.insert(idx);
+
+	return rval;
+	}
+
+	} // namespace
+
+TEST_CASE("dense table agrees with lazy matching")
+	{
+	auto m = make_test_set();
+	std::set<AcceptIdx> expected = {1, 2, 4};
+
+	// The first rounds compute states lazily, later ones run on the
+	// dense table once it has been built.
+	for ( int round = 0; round < 5; ++round )
+		{
+		CHECK_EQ(match_in_chunks(m, test_payload, strlen(test_payload)), expected);
+		CHECK_EQ(match_in_chunks(m, test_payload, 7), expected);
+		CHECK_EQ(match_in_chunks(m, test_payload, 1), expected);
+		}
+
+	CHECK(m->DFA()->Dense() != nullptr);
+	CHECK_EQ(match_in_chunks(m, "HTTP/1.0 200 OK\r\n", 3), std::set<AcceptIdx>{3});
+	CHECK(match_in_chunks(m, "POST /x HTTP/1.1\r\n", 5).empty());
+
+	delete m;
+	}
+
+TEST_CASE("DFA cache roundtrip")
+	{
+	auto m = make_test_set();
+	m->DFA()->Precompute(10000);
+	REQUIRE(m->DFA()->Complete());
+
+	char path[] = "/tmp/zeek-dfa-cache-XXXXXX";
+	int fd = mkstemp(path);
+	REQUIRE(fd >= 0);
+	close(fd);
+
+	CHECK(m->SaveSet(path, "key"));
+
+	auto loaded = new Specific_RE_Matcher(MATCH_EXACTLY, 1);
+	CHECK_FALSE(loaded->LoadSet(path, "other key"));
+	REQUIRE(loaded->LoadSet(path, "key"));
+	CHECK_EQ(loaded->DFA()->NumStates(), m->DFA()->NumStates());
+
+	// Loaded machines don't get saved again.
+	CHECK_FALSE(loaded->SaveSet(path, "key"));
+
+	std::set<AcceptIdx> expected = {1, 2, 4};
+	CHECK_EQ(match_in_chunks(loaded, test_payload, 7), expected);
+	CHECK_EQ(match_in_chunks(loaded, "HTTP/1.0 200 OK\r\n", 3), std::set<AcceptIdx>{3});
+	CHECK(match_in_chunks(loaded, "POST /x HTTP/1.1\r\n", 5).empty());
+
+	unlink(path);
+	delete loaded;
+	delete m;
+	}
+
+TEST_CASE("lazy compilation")
+	{
+	// Sets compiled lazily can build their DFAs in parallel ...
+	std::vector<Specific_RE_Matcher*> sets;
+
+	for ( int i = 0; i < 8; ++i )
+		sets.push_back(make_test_set(true));
+
+	zeek::util::detail::parallel_for(sets.size(), 4, [&sets](size_t i) { sets[i]->BuildDFA(); });
+
+	std::set<AcceptIdx> expected = {1, 2, 4};
+
+	for ( auto m : sets )
+		{
+		CHECK_EQ(match_in_chunks(m, test_payload, 7), expected);
+		delete m;
+		}
+
+	// ... while pattern constants get built by build_pending_dfas(),
+	// unless they're used before.
+	zeek::RE_Matcher used("foo[0-9]+bar");
+	zeek::RE_Matcher pending("x(y|z)*");
+	REQUIRE(used.Compile(true));
+	REQUIRE(pending.Compile(true));
+
+	CHECK(used.MatchExactly("foo42bar"));
+	build_pending_dfas(2);
+	CHECK(pending.MatchExactly("xyzzy"));
+	CHECK_FALSE(pending.MatchExactly("xa"));
+	CHECK(used.MatchAnywhere("a foo1bar b") > 0);
+	}
+
+namespace
+	{
+
+uint32_t read_u32(const u_char* p, bool swap)
+	{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return swap ? __builtin_bswap32(v) : v;
+	}
+
+uint16_t read_be16(const u_char* p)
+	{
+	return (uint16_t(p[0]) << 8) | p[1];
+	}
+
+// Reads the TCP and UDP payloads of a pcap file's IPv4 and IPv6 packets,
+// for Ethernet and raw IP link types. Returns each direction of each flow
+// as one stream, a list of its packets' payloads in the order they were
+// captured. Retransmissions and reordering aren't taken care of.
+std::vector<std::vector<std::string>> read_pcap_payloads(const char* path)
+	{
+	std::vector<std::vector<std::string>> streams;
+	std::map<std::string, size_t> stream_idx;
+
+	FILE* f = fopen(path, "rb");
+
+	if ( ! f )
+		return streams;
+
+	u_char hdr[24];
+
+	if ( fread(hdr, sizeof(hdr), 1, f) != 1 )
+		{
+		fclose(f);
+		return streams;
+		}
+
+	uint32_t magic = read_u32(hdr, false);
+	bool swap = (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1);
+
+	if ( ! swap && magic != 0xa1b2c3d4 && magic != 0xa1b23c4d )
+		{
+		fclose(f);
+		return streams;
+		}
+
+	uint32_t link_type = read_u32(hdr + 20, swap);
+	u_char rec[16];
+	std::vector<u_char> pkt;
+
+	while ( fread(rec, sizeof(rec), 1, f) == 1 )
+		{
+		pkt.resize(read_u32(rec + 8, swap));
+
+		if ( pkt.empty() || fread(pkt.data(), pkt.size(), 1, f) != 1 )
+			break;
+
+		const u_char* p = pkt.data();
+		const u_char* end = p + pkt.size();
+
+		if ( link_type == 1 ) // Ethernet
+			{
+			if ( end - p < 14 )
+				continue;
+
+			uint16_t ether_type = read_be16(p + 12);
+			p += 14;
+
+			while ( ether_type == 0x8100 && end - p >= 4 )
+				{
+				ether_type = read_be16(p + 2);
+				p += 4;
+				}
+
+			if ( ether_type != 0x0800 && ether_type != 0x86dd )
+				continue;
+			}
+
+		else if ( link_type != 101 && link_type != 12 ) // raw IP
+			continue;
+
+		if ( end - p < 20 )
+			continue;
+
+		int proto;
+		std::string key;
+
+		if ( (p[0] >> 4) == 4 )
+			{
+			int hdr_len = (p[0] & 0x0f) * 4;
+			const u_char* ip_end = p + read_be16(p + 2);
+
+			if ( ip_end > end || ip_end - p < hdr_len )
+				continue;
+
+			proto = p[9];
+			key.assign(reinterpret_cast<const char*>(p + 12), 8);
+			end = ip_end;
+			p += hdr_len;
+			}
+
+		else if ( (p[0] >> 4) == 6 && end - p >= 40 )
+			{
+			const u_char* ip_end = p + 40 + read_be16(p + 4);
+
+			if ( ip_end > end )
+				continue;
+
+			proto = p[6];
+			key.assign(reinterpret_cast<const char*>(p + 8), 32);
+			end = ip_end;
+			p += 40;
+			}
+
+		else
+			continue;
+
+		if ( proto == 6 && end - p >= 20 && end - p >= (p[12] >> 4) * 4 )
+			{
+			key.append(reinterpret_cast<const char*>(p), 4);
+			p += (p[12] >> 4) * 4;
+			}
+
+		else if ( proto == 17 && end - p >= 8 )
+			{
+			key.append(reinterpret_cast<const char*>(p), 4);
+			p += 8;
+			}
+
+		else
+			continue;
+
+		if ( p == end )
+			continue;
+
+		key.push_back(char(proto));
+
+		auto [it, inserted] = stream_idx.emplace(key, streams.size());
+
+		if ( inserted )
+			streams.emplace_back();
+
+		streams[it->second].emplace_back(reinterpret_cast<const char*>(p), end - p);
+		}
+
+	fclose(f);
+	return streams;
+	}
+
+// Reads one pattern per line.
+std::vector<std::string> read_patterns(const char* path)
+	{
+	std::vector<std::string> patterns;
+	std::ifstream in(path);
+	std::string line;
+
+	while ( std::getline(in, line) )
+		if ( ! line.empty() )
+			patterns.push_back(line);
+
+	return patterns;
+	}
+
+	} // namespace
+
+// Throughput of signature-style matching on recorded payload. Skipped by
+// default; run with
+//
+//     ZEEK_RE_BENCH_PCAP=trace.pcap zeek --test --test-case='*throughput*' --no-skip
+//
+// Each direction of each TCP or UDP flow in the trace gets matched as one
+// stream, packet by packet. ZEEK_RE_BENCH_PATTERNS may name a file with one
+// pattern per line to use instead of the built-in HTTP ones, and
+// ZEEK_RE_BENCH_ROUNDS the number of times to go over the trace.
+TEST_CASE("pattern set matching throughput" * doctest::skip())
+	{
+	const char* pcap = getenv("ZEEK_RE_BENCH_PCAP");
+
+	if ( ! pcap )
+		{
+		MESSAGE("ZEEK_RE_BENCH_PCAP not set");
+		return;
+		}
+
+	auto streams = read_pcap_payloads(pcap);
+	REQUIRE(! streams.empty());
+
+	Specific_RE_Matcher* m;
+
+	if ( const char* patterns_file = getenv("ZEEK_RE_BENCH_PATTERNS") )
+		{
+		auto patterns = read_patterns(patterns_file);
+		REQUIRE(! patterns.empty());
+
+		m = new Specific_RE_Matcher(MATCH_EXACTLY, 1);
+		string_list exprs;
+		int_list ids;
+
+		for ( size_t i = 0; i < patterns.size(); ++i )
+			{
+			exprs.push_back(const_cast<char*>(patterns[i].c_str()));
+			ids.push_back(i + 1);
+			}
+
+		REQUIRE(m->CompileSet(exprs, ids));
+		}
+	else
+		m = make_test_set();
+
+	int rounds = 10;
+
+	if ( const char* r = getenv("ZEEK_RE_BENCH_ROUNDS") )
+		rounds = std::max(1, atoi(r));
+
+	size_t bytes = 0;
+	size_t matches = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for ( int i = 0; i < rounds; ++i )
+		for ( const auto& stream : streams )
+			{
+			RE_Match_State state(m);
+
+			for ( size_t j = 0; j < stream.size(); ++j )
+				{
+				state.Match(reinterpret_cast<const u_char*>(stream[j].data()),
+				            stream[j].size(), j == 0, j + 1 == stream.size(), false);
+				bytes += stream[j].size();
+				}
+
+			matches += state.AcceptedMatches().size();
+			}
+
+	std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+	MESSAGE("matched " << bytes / secs.count() / 1e6 << " MB/s over " << streams.size()
+	                   << " streams, " << matches / rounds << " matches per round, "
+	                   << m->DFA()->NumStates() << " DFA states");
+
+	delete m;
+	}
+
+TEST_SUITE_END();
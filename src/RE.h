@@ -7,6 +7,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "zeek/CCL.h"
 #include "zeek/EquivClass.h"
@@ -29,6 +30,7 @@ namespace detail
 class NFA_Machine;
 class DFA_Machine;
 class DFA_State;
+class DFA_DenseTable;
 class Specific_RE_Matcher;
 class CCL;
 
@@ -68,6 +70,8 @@ public:
 
 	void SetPat(const char* pat) { pattern_text = util::copy_string(pat); }
 
+	// Parses the pattern and builds its DFA. If lazy is true, the DFA
+	// gets built by build_pending_dfas() or on first use instead.
 	bool Compile(bool lazy = false);
 
 	// The following is vestigial from flex's use of "{name}" definitions.
@@ -101,7 +105,28 @@ public:
 	// 'idx' contains indizes associated with the expressions.
 	// On matching, the set of indizes is returned which correspond
 	// to the matching expressions.  (idx must not contain zeros).
-	bool CompileSet(const string_list& set, const int_list& idx);
+	// If lazy is true, leaves building the DFA to BuildDFA() or the
+	// first use.
+	bool CompileSet(const string_list& set, const int_list& idx, bool lazy = false);
+
+	// Builds the DFA of a matcher that was compiled lazily. Parsing
+	// patterns goes through the global RE parser and must stay on the
+	// main thread, but this only touches the matcher's own NFA, so
+	// different matchers can build their DFAs in parallel.
+	void BuildDFA();
+
+	// Sets up the matcher from a DFA cache file that SaveSet() wrote
+	// with the same key, instead of compiling a set. Returns false if
+	// there's no usable file.
+	bool LoadSet(const std::string& path, const std::string& key);
+
+	// Writes the matcher's DFA to a cache file, see DFA_Machine::Save().
+	bool SaveSet(const std::string& path, const std::string& key);
+
+	// Matches s against a set compiled with CompileSet() in a single
+	// pass over the input.  Fills 'matches' with the indices of all the
+	// expressions matching a prefix of s, in increasing order.
+	void MatchSet(const String* s, std::vector<AcceptIdx>& matches);
 
 	// Returns the position in s just beyond where the first match
 	// occurs, or 0 if there is no such position in s.  Note that
@@ -118,7 +143,13 @@ public:
 
 	const char* PatternText() const { return pattern_text; }
 
-	DFA_Machine* DFA() const { return dfa; }
+	DFA_Machine* DFA()
+		{
+		if ( pending_nfa )
+			BuildLazyDFA();
+
+		return dfa;
+		}
 
 	void Dump(FILE* f);
 
@@ -138,6 +169,9 @@ protected:
 	bool MatchAll(const u_char* bv, int n);
 	int Match(const u_char* bv, int n);
 
+	// Builds the DFA of a lazily compiled matcher on its first use.
+	void BuildLazyDFA();
+
 	match_type mt;
 	int multiline;
 	char* pattern_text;
@@ -148,6 +182,7 @@ protected:
 	EquivClass equiv_class;
 	int* ecs;
 	DFA_Machine* dfa;
+	NFA_Machine* pending_nfa;
 	CCL* any_ccl;
 	AcceptingSet* accepted;
 	};
@@ -160,9 +195,13 @@ public:
 		dfa = matcher->DFA() ? matcher->DFA() : nullptr;
 		ecs = matcher->EC()->EquivClasses();
 		current_pos = -1;
+		offset = 0;
 		current_state = nullptr;
+		pinned_state = nullptr;
 		}
 
+	~RE_Match_State();
+
 	const AcceptingMatchSet& AcceptedMatches() const { return accepted_matches; }
 
 	// Returns the number of bytes feeded into the matcher so far
@@ -172,27 +211,58 @@ public:
 	// If clear is true, starts matching over.
 	bool Match(const u_char* bv, int n, bool bol, bool eol, bool clear);
 
-	void Clear()
-		{
-		current_pos = -1;
-		current_state = nullptr;
-		accepted_matches.clear();
-		}
+	// Feeds further bytes of the chunk passed to the last Match(), with
+	// match positions continuing from there. Returns true for new matches.
+	bool MatchMore(const u_char* bv, int n, bool eol);
+
+	// The state the input so far has led to, nullptr if the DFA jammed.
+	DFA_State* CurrentState() const { return current_state; }
+
+	// Continues from a state that another matcher of the same DFA reached
+	// with the given matches, after having been fed pos bytes of its
+	// current chunk.
+	void Restore(DFA_State* state, const AcceptingMatchSet& matches, int pos);
+
+	// Sets where in the overall input the next chunk starts. Match
+	// positions get recorded relative to that rather than to the chunk.
+	void SetOffset(MatchPos arg_offset) { offset = arg_offset; }
+
+	void Clear();
 
 	void AddMatches(const AcceptingSet& as, MatchPos position);
 
 protected:
+	// Holds a reference to the state we'll continue from, so that the
+	// DFA's state cache can't free it in between calls.
+	void Pin(DFA_State* state);
+
+	// Transitions on the given equivalence class, recording matches.
+	// Returns false if the DFA jams.
+	bool Step(int ec);
+
+	// Feeds the bytes, using the dense table where it has transitions.
+	void MatchDense(const DFA_DenseTable* dense, const u_char* bv, int n);
+
+	// Feeds the bytes and then, if eol is set, an end-of-line.
+	void Feed(const u_char* bv, int n, bool eol);
+
 	DFA_Machine* dfa;
 	int* ecs;
 
 	AcceptingMatchSet accepted_matches;
 	DFA_State* current_state;
+	DFA_State* pinned_state;
 	int current_pos;
+	MatchPos offset;
 	};
 
 extern RE_Matcher* RE_Matcher_conjunction(const RE_Matcher* re1, const RE_Matcher* re2);
 extern RE_Matcher* RE_Matcher_disjunction(const RE_Matcher* re1, const RE_Matcher* re2);
 
+// Builds the DFAs of all patterns compiled lazily so far, using up to
+// num_threads threads (zero meaning one per core).
+extern void build_pending_dfas(size_t num_threads);
+
 	} // namespace detail
 
 class RE_Matcher final
@@ -263,6 +263,13 @@ void Reporter::WeirdHelper(EventHandlerPtr event, ValPList vl, const char* fmt_n
 	va_end(ap);
 	}
 
+template <class F>
+void Reporter::WeirdHelper(EventHandlerPtr event, F&& build_args, const char* name)
+	{
+	if ( event || plugin_mgr->HavePluginForHook(plugin::HOOK_REPORTER) )
+		WeirdHelper(event, build_args(), "%s", name);
+	}
+
 void Reporter::UpdateWeirdStats(const char* name)
 	{
 	++weird_count;
@@ -425,7 +432,12 @@ void Reporter::Weird(const char* name, const char* addl, const char* source)
 			return;
 		}
 
-	WeirdHelper(net_weird, {new StringVal(addl), new StringVal(source)}, "%s", name);
+	auto build_args = [&]() -> ValPList
+	{
+		return {new StringVal(addl), new StringVal(source)};
+	};
+
+	WeirdHelper(net_weird, build_args, name);
 	}
 
 void Reporter::Weird(file_analysis::File* f, const char* name, const char* addl, const char* source)
@@ -444,8 +456,12 @@ void Reporter::Weird(file_analysis::File* f, const char* name, const char* addl,
 				return;
 		}
 
-	WeirdHelper(file_weird, {f->ToVal()->Ref(), new StringVal(addl), new StringVal(source)}, "%s",
-	            name);
+	auto build_args = [&]() -> ValPList
+	{
+		return {f->ToVal()->Ref(), new StringVal(addl), new StringVal(source)};
+	};
+
+	WeirdHelper(file_weird, build_args, name);
 	}
 
 void Reporter::Weird(Connection* conn, const char* name, const char* addl, const char* source)
@@ -464,8 +480,12 @@ void Reporter::Weird(Connection* conn, const char* name, const char* addl, const
 				return;
 		}
 
-	WeirdHelper(conn_weird, {conn->GetVal()->Ref(), new StringVal(addl), new StringVal(source)},
-	            "%s", name);
+	auto build_args = [&]() -> ValPList
+	{
+		return {conn->GetVal()->Ref(), new StringVal(addl), new StringVal(source)};
+	};
+
+	WeirdHelper(conn_weird, build_args, name);
 	}
 
 void Reporter::Weird(RecordValPtr conn_id, StringValPtr uid, const char* name, const char* addl,
@@ -484,9 +504,12 @@ void Reporter::Weird(RecordValPtr conn_id, StringValPtr uid, const char* name, c
 				return;
 		}
 
-	WeirdHelper(expired_conn_weird,
-	            {conn_id.release(), uid.release(), new StringVal(addl), new StringVal(source)},
-	            "%s", name);
+	auto build_args = [&]() -> ValPList
+	{
+		return {conn_id.release(), uid.release(), new StringVal(addl), new StringVal(source)};
+	};
+
+	WeirdHelper(expired_conn_weird, build_args, name);
 	}
 
 void Reporter::Weird(const IPAddr& orig, const IPAddr& resp, const char* name, const char* addl,
@@ -505,9 +528,12 @@ void Reporter::Weird(const IPAddr& orig, const IPAddr& resp, const char* name, c
 				return;
 		}
 
-	WeirdHelper(flow_weird,
-	            {new AddrVal(orig), new AddrVal(resp), new StringVal(addl), new StringVal(source)},
-	            "%s", name);
+	auto build_args = [&]() -> ValPList
+	{
+		return {new AddrVal(orig), new AddrVal(resp), new StringVal(addl), new StringVal(source)};
+	};
+
+	WeirdHelper(flow_weird, build_args, name);
 	}
 
 void Reporter::DoLog(const char* prefix, EventHandlerPtr event, FILE* out, Connection* conn,
@@ -295,6 +295,10 @@ private:
 	// and that takes va_list anyway.
 	void WeirdHelper(EventHandlerPtr event, ValPList vl, const char* fmt_name, ...)
 		__attribute__((format(printf, 4, 5)));
+
+	// Like the above, but calls build_args for the event's arguments only
+	// if an event handler or a plugin hooking into the reporter sees them.
+	template <class F> void WeirdHelper(EventHandlerPtr event, F&& build_args, const char* name);
 	;
 	void UpdateWeirdStats(const char* name);
 	inline bool WeirdOnSamplingWhiteList(const char* name)
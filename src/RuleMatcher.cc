@@ -4,7 +4,16 @@
 #include "zeek/zeek-config.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "zeek/DFA.h"
 #include "zeek/DebugLogger.h"
@@ -23,6 +32,7 @@
 #include "zeek/Var.h"
 #include "zeek/ZeekString.h"
 #include "zeek/analyzer/Analyzer.h"
+#include "zeek/digest.h"
 #include "zeek/module_util.h"
 
 using namespace std;
@@ -49,6 +59,187 @@ static bool is_member_of(const int_list& l, int_list::value_type v)
 	return std::find(l.begin(), l.end(), v) != l.end();
 	}
 
+LiteralPrefilter::LiteralPrefilter() : bigrams(65536 / 64), max_len(0) { }
+
+void LiteralPrefilter::Add(const std::string& lit, bool nocase, int gate)
+	{
+	assert(lit.size() >= 2);
+
+	int idx = literals.size();
+	literals.push_back({lit, nocase, gate});
+	max_len = std::max(max_len, lit.size());
+
+	// Index all case variants of the first two bytes.
+	u_char c0[2] = {u_char(lit[0]), u_char(lit[0])};
+	u_char c1[2] = {u_char(lit[1]), u_char(lit[1])};
+
+	if ( nocase )
+		{
+		c0[1] = toupper(c0[0]);
+		c1[1] = toupper(c1[0]);
+		}
+
+	for ( int i = 0; i < 2; ++i )
+		for ( int j = 0; j < 2; ++j )
+			{
+			if ( (i && c0[1] == c0[0]) || (j && c1[1] == c1[0]) )
+				continue;
+
+			uint16_t key = Key(c0[i], c1[j]);
+			bigrams[key >> 6] |= uint64_t(1) << (key & 63);
+			candidates[key].push_back(idx);
+			}
+
+	for ( auto c : c0 )
+		if ( std::find(first_bytes.begin(), first_bytes.end(), c) == first_bytes.end() )
+			first_bytes.push_back(c);
+	}
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+#define SCAN_BLOCK 16
+
+// Beyond this many distinct first bytes, comparing against each of them
+// costs more than it saves over the plain bigram lookups.
+#define SCAN_MAX_FIRST_BYTES 8
+
+// Returns a mask of the positions in the SCAN_BLOCK bytes at p holding one
+// of the given bytes. Each position takes SCAN_LANE_BITS bits of the mask.
+#if defined(__SSE2__)
+#define SCAN_LANE_BITS 1
+
+static inline uint64_t first_byte_mask(const u_char* p, const std::vector<u_char>& bytes)
+	{
+	__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i hits = _mm_setzero_si128();
+
+	for ( auto b : bytes )
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(char(b))));
+
+	return uint32_t(_mm_movemask_epi8(hits));
+	}
+#else
+#define SCAN_LANE_BITS 4
+
+static inline uint64_t first_byte_mask(const u_char* p, const std::vector<u_char>& bytes)
+	{
+	uint8x16_t block = vld1q_u8(p);
+	uint8x16_t hits = vdupq_n_u8(0);
+
+	for ( auto b : bytes )
+		hits = vorrq_u8(hits, vceqq_u8(block, vdupq_n_u8(b)));
+
+	return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+	}
+#endif
+#endif
+
+void LiteralPrefilter::Scan(const u_char* data, int len, std::vector<bool>* opened) const
+	{
+	int i = 0;
+
+#ifdef SCAN_BLOCK
+	if ( first_bytes.size() <= SCAN_MAX_FIRST_BYTES )
+		{
+		// Every position of a block needs a byte after it for the bigram.
+		for ( ; i + SCAN_BLOCK < len; i += SCAN_BLOCK )
+			{
+			uint64_t mask = first_byte_mask(data + i, first_bytes);
+
+			while ( mask )
+				{
+				int lane = __builtin_ctzll(mask) / SCAN_LANE_BITS;
+				ScanAt(data, len, i + lane, opened);
+				mask &= ~((uint64_t(1) << ((lane + 1) * SCAN_LANE_BITS)) - 1);
+				}
+			}
+		}
+#endif
+
+	for ( ; i + 1 < len; ++i )
+		ScanAt(data, len, i, opened);
+	}
+
+void LiteralPrefilter::ScanAt(const u_char* data, int len, int i, std::vector<bool>* opened) const
+	{
+	uint16_t key = Key(data[i], data[i + 1]);
+
+	if ( ! (bigrams[key >> 6] & (uint64_t(1) << (key & 63))) )
+		return;
+
+	for ( int idx : candidates.find(key)->second )
+		{
+		const Literal& l = literals[idx];
+
+		if ( (*opened)[l.gate] || l.text.size() > static_cast<size_t>(len - i) )
+			continue;
+
+		bool found = true;
+
+		for ( size_t k = 2; k < l.text.size(); ++k )
+			{
+			u_char c = data[i + k];
+
+			if ( l.nocase )
+				c = tolower(c);
+
+			if ( c != u_char(l.text[k]) )
+				{
+				found = false;
+				break;
+				}
+			}
+
+		if ( found )
+			(*opened)[l.gate] = true;
+		}
+	}
+
+PrefixStateCache::PrefixStateCache(int size) : entries(size) { }
+
+PrefixStateCache::~PrefixStateCache()
+	{
+	for ( auto& e : entries )
+		Unref(e.state);
+	}
+
+PrefixStateCache::Entry& PrefixStateCache::Slot(const u_char* prefix)
+	{
+	std::string_view key(reinterpret_cast<const char*>(prefix), PREFIX_LEN);
+	return entries[std::hash<std::string_view>{}(key) % entries.size()];
+	}
+
+const PrefixStateCache::Entry* PrefixStateCache::Lookup(const u_char* prefix)
+	{
+	const Entry& e = Slot(prefix);
+
+	// Evicted states would have to compute all their transitions anew,
+	// so we rather start over.
+	if ( e.prefix.compare(0, e.prefix.npos, prefix, PREFIX_LEN) != 0 ||
+	     (e.state && e.state->Evicted()) )
+		{
+		++misses;
+		return nullptr;
+		}
+
+	++hits;
+	return &e;
+	}
+
+void PrefixStateCache::Insert(const u_char* prefix, DFA_State* state,
+                              const AcceptingMatchSet& matches)
+	{
+	Entry& e = Slot(prefix);
+
+	if ( state )
+		Ref(state);
+
+	Unref(e.state);
+
+	e.prefix.assign(prefix, PREFIX_LEN);
+	e.state = state;
+	e.matches = matches;
+	}
+
 RuleHdrTest::RuleHdrTest(Prot arg_prot, uint32_t arg_offset, uint32_t arg_size, Comp arg_comp,
                          maskedvalue_list* arg_vals)
 	{
@@ -142,6 +333,7 @@ RuleHdrTest::~RuleHdrTest()
 		for ( auto pset : psets[i] )
 			{
 			delete pset->re;
+			delete pset->prefix_cache;
 			delete pset;
 			}
 		}
@@ -186,6 +378,8 @@ RuleEndpointState::RuleEndpointState(analyzer::Analyzer* arg_analyzer, bool arg_
                                      RuleEndpointState* arg_opposite, analyzer::pia::PIA* arg_PIA)
 	{
 	payload_size = -1;
+	payload_offset = 0;
+	live_payload_matchers = 0;
 	analyzer = arg_analyzer;
 	is_orig = arg_is_orig;
 
@@ -215,6 +409,9 @@ RuleFileMagicState::~RuleFileMagicState()
 		delete matcher->state;
 		delete matcher;
 		}
+
+	for ( auto state : anchored )
+		delete state;
 	}
 
 RuleMatcher::RuleMatcher(int arg_RE_level)
@@ -223,6 +420,11 @@ RuleMatcher::RuleMatcher(int arg_RE_level)
 	RE_level = arg_RE_level;
 	parse_error = false;
 	has_non_file_magic_rule = false;
+	num_gates = 0;
+	match_calls = 0;
+	bytes_matched = 0;
+	unattributed_match_time = 0.0;
+	matchers_retired = 0;
 	}
 
 RuleMatcher::~RuleMatcher()
@@ -232,6 +434,13 @@ RuleMatcher::~RuleMatcher()
 #endif
 	Delete(root);
 
+	for ( auto set : magic_sets )
+		{
+		delete set->re;
+		delete set->prefix_cache;
+		delete set;
+		}
+
 	for ( auto rule : rules )
 		delete rule;
 	}
@@ -255,6 +464,9 @@ bool RuleMatcher::ReadFiles(const std::vector<std::string>& files)
 #endif
 
 	parse_error = false;
+	dfa_cache_dir = id::find_val<StringVal>("sig_dfa_cache_dir")->ToStdString();
+
+	double t0 = util::current_time(true);
 
 	for ( const auto& f : files )
 		{
@@ -275,12 +487,30 @@ bool RuleMatcher::ReadFiles(const std::vector<std::string>& files)
 	if ( parse_error )
 		return false;
 
+	double t1 = util::current_time(true);
+
 	BuildRulesTree();
 
+	double t2 = util::current_time(true);
+
 	string_list exprs[Rule::TYPES];
 	int_list ids[Rule::TYPES];
 	BuildRegEx(root, exprs, ids);
 
+	double t3 = util::current_time(true);
+
+	setup_times.parse = t1 - t0;
+	setup_times.tree = t2 - t1;
+	setup_times.regex = t3 - t2;
+	setup_times.dfa = 0.0;
+
+	CompilePatternSets();
+
+	rule_profiles.resize(Rule::rule_counter);
+
+	DBG_LOG(DBG_RULES, "setup times: parse %.6f, tree %.6f, regex %.6f, dfa %.6f",
+	        setup_times.parse, setup_times.tree, setup_times.regex, setup_times.dfa);
+
 	return ! parse_error;
 	}
 
@@ -395,7 +625,7 @@ void RuleMatcher::BuildRegEx(RuleHdrTest* hdr_test, string_list* exprs, int_list
 		{
 		for ( int i = 0; i < Rule::TYPES; ++i )
 			if ( exprs[i].length() )
-				BuildPatternSets(&hdr_test->psets[i], exprs[i], ids[i]);
+				BuildPatternSets(&hdr_test->psets[i], (Rule::PatternType)i, exprs[i], ids[i]);
 		}
 
 	// Get the patterns on all of our children.
@@ -408,51 +638,575 @@ void RuleMatcher::BuildRegEx(RuleHdrTest* hdr_test, string_list* exprs, int_list
 
 		for ( int i = 0; i < Rule::TYPES; ++i )
 			{
-			loop_over_list(child_exprs[i], j)
-				{
-				exprs[i].push_back(child_exprs[i][j]);
-				ids[i].push_back(child_ids[i][j]);
-				}
+			loop_over_list(child_exprs[i], j)
+				{
+				exprs[i].push_back(child_exprs[i][j]);
+				ids[i].push_back(child_ids[i][j]);
+				}
+			}
+		}
+
+	// If we're on the RE_level, all patterns gathered now
+	// form the regexprs.
+	if ( hdr_test->level == RE_level )
+		{
+		for ( int i = 0; i < Rule::TYPES; ++i )
+			if ( exprs[i].length() )
+				BuildPatternSets(&hdr_test->psets[i], (Rule::PatternType)i, exprs[i], ids[i]);
+		}
+
+	// If we're below the RE_level, the regexprs remains empty.
+	}
+
+void RuleMatcher::CollectPatternSets(RuleHdrTest* hdr_test,
+                                     std::vector<RuleHdrTest::PatternSet*>* sets) const
+	{
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		for ( const auto& set : hdr_test->psets[i] )
+			sets->push_back(set);
+
+	for ( RuleHdrTest* h = hdr_test->child; h; h = h->sibling )
+		CollectPatternSets(h, sets);
+
+	if ( hdr_test == root )
+		for ( const auto& set : magic_sets )
+			sets->push_back(set);
+	}
+
+// Identifies a pattern group in the DFA cache. The patterns' indices are
+// part of it, as they are what the DFA reports for matches.
+static string dfa_cache_key(const string_list& exprs, const int_list& ids)
+	{
+	string key;
+
+	loop_over_list(exprs, i)
+		{
+		key += std::to_string(ids[i]) + ":";
+		key += exprs[i];
+		key += "\n";
+		}
+
+	return key;
+	}
+
+string RuleMatcher::DFACachePath(const string& key) const
+	{
+	u_char digest[MD5_DIGEST_LENGTH];
+	internal_md5(reinterpret_cast<const u_char*>(key.data()), key.size(), digest);
+
+	return dfa_cache_dir + "/" + md5_digest_print(digest) + ".dfa";
+	}
+
+void RuleMatcher::CompilePatternSets()
+	{
+	std::vector<RuleHdrTest::PatternSet*> sets;
+	CollectPatternSets(root, &sets);
+
+	bool use_cache = ! dfa_cache_dir.empty();
+	std::vector<string> keys(sets.size());
+	// Not a vector<bool>, as threads set separate elements.
+	std::vector<char> loaded(sets.size(), 0);
+
+	auto load = [&](size_t i)
+	{
+		keys[i] = dfa_cache_key(sets[i]->patterns, sets[i]->ids);
+		loaded[i] = sets[i]->re->LoadSet(DFACachePath(keys[i]), keys[i]);
+	};
+
+	double t0 = util::current_time(true);
+
+	if ( use_cache )
+		util::detail::parallel_for(sets.size(), pattern_compile_threads, load);
+
+	double t1 = util::current_time(true);
+
+	for ( size_t i = 0; i < sets.size(); ++i )
+		if ( ! loaded[i] )
+			sets[i]->re->CompileSet(sets[i]->patterns, sets[i]->ids, true);
+
+	double t2 = util::current_time(true);
+
+	bool save = use_cache;
+
+	if ( save && ! util::detail::ensure_intermediate_dirs(dfa_cache_dir.c_str()) )
+		{
+		reporter->Warning("cannot create DFA cache directory %s", dfa_cache_dir.c_str());
+		save = false;
+		}
+
+	std::atomic<int> saved = 0;
+
+	auto build = [&](size_t i)
+	{
+		auto re = sets[i]->re;
+
+		if ( loaded[i] )
+			return;
+
+		re->BuildDFA();
+
+		if ( ! re->DFA() )
+			return;
+
+		if ( sig_precompute_dfa_states )
+			re->DFA()->Precompute(sig_precompute_dfa_states);
+
+		if ( save && re->SaveSet(DFACachePath(keys[i]), keys[i]) )
+			++saved;
+	};
+
+	util::detail::parallel_for(sets.size(), pattern_compile_threads, build);
+
+	double t3 = util::current_time(true);
+
+	setup_times.regex += t2 - t1;
+	setup_times.dfa += (t1 - t0) + (t3 - t2);
+
+	DBG_LOG(DBG_RULES, "compiled %zu pattern sets, %d loaded from and %d saved to the DFA cache",
+	        sets.size(), int(std::count(loaded.begin(), loaded.end(), 1)), saved.load());
+	}
+
+// Returns the position of the ']' closing the character class that starts
+// at re[i], or string::npos if there's none.
+static size_t class_end(const string& re, size_t i)
+	{
+	if ( ++i < re.size() && re[i] == '^' )
+		++i;
+
+	// The first character of a class may be a ']'.
+	if ( i < re.size() && re[i] == '\\' )
+		++i;
+
+	for ( ++i; i < re.size() && re[i] != ']'; ++i )
+		{
+		if ( re[i] == '\\' )
+			++i;
+
+		else if ( re[i] == '[' && i + 1 < re.size() && re[i + 1] == ':' )
+			{
+			auto end = re.find(":]", i + 2);
+			if ( end == string::npos )
+				return string::npos;
+
+			i = end + 1;
+			}
+		}
+
+	return i < re.size() ? i : string::npos;
+	}
+
+// Returns the position of the '"' closing the string that starts at re[i],
+// or string::npos if there's none.
+static size_t string_end(const string& re, size_t i)
+	{
+	for ( ++i; i < re.size() && re[i] != '"'; ++i )
+		if ( re[i] == '\\' )
+			++i;
+
+	return i < re.size() ? i : string::npos;
+	}
+
+// Returns true if the regular expression has no alternation on its top
+// level and its parentheses balance.
+static bool is_simple_sequence(const string& re)
+	{
+	int depth = 0;
+
+	for ( size_t i = 0; i < re.size(); ++i )
+		{
+		switch ( re[i] )
+			{
+			case '\\':
+				++i;
+				break;
+
+			case '"':
+				if ( (i = string_end(re, i)) == string::npos )
+					return false;
+				break;
+
+			case '[':
+				if ( (i = class_end(re, i)) == string::npos )
+					return false;
+				break;
+
+			case '(':
+				++depth;
+				break;
+
+			case ')':
+				if ( --depth < 0 )
+					return false;
+				break;
+
+			case '|':
+				if ( depth == 0 )
+					return false;
+				break;
+			}
+		}
+
+	return depth == 0;
+	}
+
+// Decodes the literal character at re[i], setting *next to the position
+// following it. Returns -1 if there's no literal character there, or if a
+// quantifier following it may make it optional.
+static int literal_char(const string& re, size_t i, size_t* next)
+	{
+	int c = static_cast<u_char>(re[i]);
+	*next = i + 1;
+
+	if ( c == '\\' )
+		{
+		const char* esc = re.data() + i + 1;
+		size_t n = 0;
+
+		// Only accept escapes where the RE scanner and
+		// expand_escape() agree on the extent.
+		if ( *esc == 'x' )
+			{
+			if ( ! isxdigit(esc[1]) || ! isxdigit(esc[2]) )
+				return -1;
+			}
+
+		else if ( *esc >= '0' && *esc <= '7' )
+			{
+			while ( esc[n] >= '0' && esc[n] <= '7' )
+				++n;
+
+			if ( n > 3 )
+				return -1;
+			}
+
+		else if ( *esc == '\0' || *esc == '\n' )
+			return -1;
+
+		c = static_cast<u_char>(util::detail::expand_escape(esc));
+		*next = esc - re.data();
+		}
+
+	else if ( strchr("|*+?.(){}[]^$\"", c) )
+		return -1;
+
+	if ( *next < re.size() && strchr("*?{", re[*next]) )
+		return -1;
+
+	return c;
+	}
+
+// Determines whether the pattern has the form ".*<literal>...", so that it
+// cannot match before <literal> has been seen, and no matter where the DFA
+// starts as long as it's before that. Returns the literal (lower-cased if
+// the pattern is case-insensitive) if so. This is deliberately conservative:
+// any construct we don't fully understand ends the literal.
+static bool extract_required_literal(const char* pattern, string* lit, bool* nocase)
+	{
+	string re = pattern;
+	*nocase = false;
+	lit->clear();
+
+	// Patterns given as /.../i come wrapped into "(?i:...)".
+	if ( re.size() > 5 && strncasecmp(re.data(), "(?i:", 4) == 0 && re.back() == ')' )
+		{
+		re = re.substr(4, re.size() - 5);
+		*nocase = true;
+		}
+
+	if ( re.compare(0, 2, ".*") != 0 || ! is_simple_sequence(re) )
+		return false;
+
+	size_t i = 2;
+
+	while ( i < re.size() && lit->size() < LiteralPrefilter::MAX_LENGTH )
+		{
+		size_t next;
+		int c = literal_char(re, i, &next);
+
+		if ( c < 0 )
+			break;
+
+		lit->push_back(*nocase ? tolower(c) : c);
+		i = next;
+
+		if ( i < re.size() && re[i] == '+' )
+			break;
+		}
+
+	return lit->size() >= 2;
+	}
+
+// Returns the position of the ')' closing the group that starts at re[i],
+// or string::npos if there's none or the group has alternatives.
+static size_t plain_group_end(const string& re, size_t i)
+	{
+	int depth = 0;
+
+	for ( ; i < re.size(); ++i )
+		{
+		switch ( re[i] )
+			{
+			case '\\':
+				++i;
+				break;
+
+			case '"':
+				if ( (i = string_end(re, i)) == string::npos )
+					return string::npos;
+				break;
+
+			case '[':
+				if ( (i = class_end(re, i)) == string::npos )
+					return string::npos;
+				break;
+
+			case '(':
+				++depth;
+				break;
+
+			case ')':
+				if ( --depth == 0 )
+					return i;
+				break;
+
+			case '|':
+				if ( depth == 1 )
+					return string::npos;
+				break;
+			}
+		}
+
+	return string::npos;
+	}
+
+// Determines whether a file magic pattern can only match if a certain byte
+// is at a fixed offset, i.e. whether it has the form "^.{n}<char>...". The
+// "^" is optional as file magic gets matched from the start anyway, and any
+// sequence of "." and ".{n}" may precede the character. Groups without
+// alternatives that aren't optional don't matter either.
+static bool extract_magic_anchor(const char* pattern, uint32_t* offset, u_char* byte)
+	{
+	static const uint32_t max_offset = 65535;
+
+	string re = pattern;
+
+	if ( ! is_simple_sequence(re) )
+		return false;
+
+	size_t i = (re.compare(0, 1, "^") == 0) ? 1 : 0;
+	*offset = 0;
+
+	while ( i < re.size() )
+		{
+		if ( re[i] == '(' )
+			{
+			auto end = plain_group_end(re, i);
+
+			if ( end == string::npos || re[i + 1] == '?' ||
+			     (end + 1 < re.size() && strchr("*?{", re[end + 1])) )
+				return false;
+
+			++i;
+			continue;
+			}
+
+		// Closes a group we have stepped into.
+		if ( re[i] == ')' )
+			{
+			++i;
+			continue;
+			}
+
+		if ( re[i] != '.' )
+			break;
+
+		++i;
+
+		if ( i < re.size() && re[i] == '{' )
+			{
+			auto end = re.find('}', i);
+			auto n = re.substr(i + 1, end == string::npos ? end : end - i - 1);
+
+			if ( end == string::npos || n.empty() || n.size() > 5 ||
+			     n.find_first_not_of("0123456789") != string::npos )
+				return false;
+
+			*offset += std::stoul(n);
+			i = end + 1;
+			}
+
+		else if ( i < re.size() && strchr("*+?", re[i]) )
+			return false;
+
+		else
+			++*offset;
+
+		if ( *offset > max_offset )
+			return false;
+		}
+
+	size_t next;
+	int c = i < re.size() ? literal_char(re, i, &next) : -1;
+
+	if ( c < 0 )
+		return false;
+
+	*byte = c;
+	return true;
+	}
+
+void RuleMatcher::BuildPatternSets(RuleHdrTest::pattern_set_list* dst, Rule::PatternType type,
+                                   const string_list& exprs, const int_list& ids)
+	{
+	assert(static_cast<size_t>(exprs.length()) == ids.size());
+
+	if ( type == Rule::FILE_MAGIC && sig_file_magic_index && dst == &root->psets[type] )
+		{
+		IndexFileMagic(dst, exprs, ids);
+		return;
+		}
+
+	// File magic is matched in one go, so there's nothing to gain.
+	if ( ! sig_literal_prefilter || type == Rule::FILE_MAGIC )
+		{
+		BuildPatternGroups(dst, type, exprs, ids, false);
+		return;
+		}
+
+	// Separate patterns with a required literal from the others so that
+	// their groups can be gated by the literal prefilter.
+	string_list gated_exprs;
+	int_list gated_ids;
+	string_list other_exprs;
+	int_list other_ids;
+
+	loop_over_list(exprs, i)
+		{
+		string lit;
+		bool nocase;
+
+		if ( extract_required_literal(exprs[i], &lit, &nocase) )
+			{
+			gated_exprs.push_back(exprs[i]);
+			gated_ids.push_back(ids[i]);
+			}
+		else
+			{
+			other_exprs.push_back(exprs[i]);
+			other_ids.push_back(ids[i]);
+			}
+		}
+
+	DBG_LOG(DBG_RULES, "%d of %d %s patterns gated by literal prefilter", gated_exprs.length(),
+	        exprs.length(), Rule::TypeToString(type));
+
+	if ( other_exprs.length() )
+		BuildPatternGroups(dst, type, other_exprs, other_ids, false);
+
+	if ( gated_exprs.length() )
+		BuildPatternGroups(dst, type, gated_exprs, gated_ids, true);
+	}
+
+void RuleMatcher::IndexFileMagic(RuleHdrTest::pattern_set_list* dst, const string_list& exprs,
+                                 const int_list& ids)
+	{
+	std::map<std::pair<uint32_t, u_char>, std::pair<string_list, int_list>> anchored;
+	string_list other_exprs;
+	int_list other_ids;
+
+	loop_over_list(exprs, i)
+		{
+		uint32_t offset;
+		u_char byte;
+
+		if ( extract_magic_anchor(exprs[i], &offset, &byte) )
+			{
+			auto& group = anchored[{offset, byte}];
+			group.first.push_back(exprs[i]);
+			group.second.push_back(ids[i]);
+			}
+		else
+			{
+			other_exprs.push_back(exprs[i]);
+			other_ids.push_back(ids[i]);
 			}
 		}
 
-	// If we're on the RE_level, all patterns gathered now
-	// form the regexprs.
-	if ( hdr_test->level == RE_level )
+	DBG_LOG(DBG_RULES, "%d of %d file magic patterns indexed by %zu offset/byte pairs",
+	        exprs.length() - other_exprs.length(), exprs.length(), anchored.size());
+
+	if ( other_exprs.length() )
+		BuildPatternGroups(dst, Rule::FILE_MAGIC, other_exprs, other_ids, false);
+
+	// The map is ordered by offset, so are the anchors.
+	for ( auto& [key, group] : anchored )
 		{
-		for ( int i = 0; i < Rule::TYPES; ++i )
-			if ( exprs[i].length() )
-				BuildPatternSets(&hdr_test->psets[i], exprs[i], ids[i]);
-		}
+		auto [offset, byte] = key;
 
-	// If we're below the RE_level, the regexprs remains empty.
+		if ( magic_anchors.empty() || magic_anchors.back().offset != offset )
+			magic_anchors.emplace_back(MagicAnchor{offset, {}});
+
+		RuleHdrTest::pattern_set_list sets;
+		BuildPatternGroups(&sets, Rule::FILE_MAGIC, group.first, group.second, false);
+
+		for ( auto set : sets )
+			{
+			magic_anchors.back().sets[byte].push_back(magic_sets.length());
+			magic_sets.push_back(set);
+			}
+		}
 	}
 
-void RuleMatcher::BuildPatternSets(RuleHdrTest::pattern_set_list* dst, const string_list& exprs,
-                                   const int_list& ids)
+void RuleMatcher::BuildPatternGroups(RuleHdrTest::pattern_set_list* dst, Rule::PatternType type,
+                                     const string_list& exprs, const int_list& ids, bool gated)
 	{
-	assert(static_cast<size_t>(exprs.length()) == ids.size());
-
 	// We build groups of at most sig_max_group_size regexps.
 
 	string_list group_exprs;
 	int_list group_ids;
 
+	std::vector<int> order(exprs.length());
+	std::iota(order.begin(), order.end(), 0);
+
+	// Group payload patterns by depth, so that endpoints can retire the
+	// groups of patterns that only match early on.
+	if ( type == Rule::PAYLOAD )
+		std::stable_sort(order.begin(), order.end(), [&ids](int a, int b)
+		                 { return PatternDepth(ids[a]) < PatternDepth(ids[b]); });
+
 	for ( int i = 0; i < exprs.length() + 1 /* sic! */; i++ )
 		{
 		if ( i < exprs.length() )
 			{
-			group_exprs.push_back(exprs[i]);
-			group_ids.push_back(ids[i]);
+			group_exprs.push_back(exprs[order[i]]);
+			group_ids.push_back(ids[order[i]]);
 			}
 
 		if ( group_exprs.length() > sig_max_group_size || i == exprs.length() )
 			{
 			RuleHdrTest::PatternSet* set = new RuleHdrTest::PatternSet;
-			set->re = new Specific_RE_Matcher(MATCH_EXACTLY, 1);
-			set->re->CompileSet(group_exprs, group_ids);
 			set->patterns = group_exprs;
 			set->ids = group_ids;
+			set->re = new Specific_RE_Matcher(MATCH_EXACTLY, 1);
+			SetMatchLimits(set);
+
+			// Gated sets start matching somewhere within the payload.
+			if ( type == Rule::PAYLOAD && ! gated && sig_prefix_cache_size > 0 )
+				set->prefix_cache = new PrefixStateCache(sig_prefix_cache_size);
+
+			if ( gated )
+				{
+				set->gate = num_gates++;
+
+				for ( const auto& expr : group_exprs )
+					{
+					string lit;
+					bool nocase;
+					extract_required_literal(expr, &lit, &nocase);
+					prefilters[type].Add(lit, nocase, set->gate);
+					}
+				}
+
 			dst->push_back(set);
 
 			group_exprs.clear();
@@ -461,6 +1215,46 @@ void RuleMatcher::BuildPatternSets(RuleHdrTest::pattern_set_list* dst, const str
 		}
 	}
 
+uint32_t RuleMatcher::PatternDepth(int id)
+	{
+	for ( const auto& p : Rule::rule_table[id - 1]->patterns )
+		{
+		if ( p->id != id )
+			continue;
+
+		// Patterns without a depth have INT_MAX, so this is where
+		// AllRulePatternsMatched() stops accepting their matches, too.
+		return std::min(uint64_t(p->offset) + p->depth, uint64_t(UINT32_MAX));
+		}
+
+	return UINT32_MAX;
+	}
+
+void RuleMatcher::SetMatchLimits(RuleHdrTest::PatternSet* set)
+	{
+	std::set<Rule*> rules;
+	uint32_t depth = 0;
+
+	for ( auto id : set->ids )
+		{
+		rules.insert(Rule::rule_table[id - 1]);
+		depth = std::max(depth, PatternDepth(id));
+		}
+
+	set->depth = depth;
+
+	for ( const auto& r : rules )
+		{
+		auto sized = std::any_of(r->conditions.begin(), r->conditions.end(), [](RuleCondition* c)
+		                         { return dynamic_cast<RuleConditionPayloadSize*>(c); });
+
+		if ( ! sized )
+			return;
+		}
+
+	set->sized_rules.assign(rules.begin(), rules.end());
+	}
+
 // Get a 8/16/32-bit value from the given position in the packet header
 static inline uint32_t getval(const u_char* data, int size)
 	{
@@ -622,6 +1416,8 @@ RuleFileMagicState* RuleMatcher::InitFileMagic() const
 
 	// Save some memory.
 	state->matchers.resize(0);
+
+	state->anchored.resize(magic_sets.length());
 	return state;
 	}
 
@@ -678,6 +1474,25 @@ RuleMatcher::MIME_Matches* RuleMatcher::Match(RuleFileMagicState* state, const u
 			newmatch = true;
 		}
 
+	// Of the indexed patterns, only those can match that find their
+	// byte at their offset.
+	for ( const auto& anchor : magic_anchors )
+		{
+		if ( anchor.offset >= len )
+			break;
+
+		for ( int idx : anchor.sets[data[anchor.offset]] )
+			{
+			if ( ! state->anchored[idx] )
+				state->anchored[idx] = new RE_Match_State(magic_sets[idx]->re);
+
+			if ( state->anchored[idx]->Match(data, len, true, false, true) )
+				newmatch = true;
+
+			state->used.insert(idx);
+			}
+		}
+
 	if ( ! newmatch )
 		return rval;
 
@@ -691,6 +1506,12 @@ RuleMatcher::MIME_Matches* RuleMatcher::Match(RuleFileMagicState* state, const u
 		accepted_matches.insert(ams.begin(), ams.end());
 		}
 
+	for ( int idx : state->used )
+		{
+		const AcceptingMatchSet& ams = state->anchored[idx]->AcceptedMatches();
+		accepted_matches.insert(ams.begin(), ams.end());
+		}
+
 	// Find rules for which patterns have matched.
 	set<Rule*> rule_matches;
 
@@ -755,20 +1576,7 @@ RuleEndpointState* RuleMatcher::InitEndpoint(analyzer::Analyzer* analyzer, const
 		// If we're on or above the RE_level, we may have some
 		// pattern matching to do.
 		if ( hdr_test->level <= RE_level )
-			{
-			for ( int i = Rule::PAYLOAD; i < Rule::TYPES; ++i )
-				{
-				for ( const auto& set : hdr_test->psets[i] )
-					{
-					assert(set->re);
-
-					auto* m = new RuleEndpointState::Matcher;
-					m->state = new RE_Match_State(set->re);
-					m->type = (Rule::PatternType)i;
-					state->matchers.push_back(m);
-					}
-				}
-			}
+			AddEndpointMatchers(state, hdr_test);
 
 		if ( ip )
 			{
@@ -832,12 +1640,83 @@ RuleEndpointState* RuleMatcher::InitEndpoint(analyzer::Analyzer* analyzer, const
 	state->hdr_tests.resize(0);
 	state->matchers.resize(0);
 
+	if ( num_gates )
+		state->opened_gates.resize(num_gates);
+
 	// Send BOL to payload matchers.
 	Match(state, Rule::PAYLOAD, (const u_char*)"", 0, true, false, false);
 
 	return state;
 	}
 
+void RuleMatcher::AddEndpointMatchers(RuleEndpointState* state, RuleHdrTest* hdr_test)
+	{
+	for ( int i = Rule::PAYLOAD; i < Rule::TYPES; ++i )
+		{
+		for ( const auto& set : hdr_test->psets[i] )
+			{
+			assert(set->re);
+
+			auto* m = new RuleEndpointState::Matcher;
+			m->state = new RE_Match_State(set->re);
+			m->type = (Rule::PatternType)i;
+			m->gate = set->gate;
+			m->active = (set->gate < 0);
+			m->retired = false;
+			m->prefix_cache = set->prefix_cache;
+			m->set = set;
+			state->matchers.push_back(m);
+
+			if ( m->type == Rule::PAYLOAD )
+				++state->live_payload_matchers;
+			}
+		}
+	}
+
+double RuleMatcher::BenchmarkPayload(const u_char* data, int data_len, int chunk_size)
+	{
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+
+	// A null analyzer tells Match() that there's no connection.
+	RuleEndpointState* state = new RuleEndpointState(nullptr, true, nullptr, nullptr);
+
+	rule_hdr_test_list tests;
+	tests.push_back(root);
+
+	loop_over_list(tests, h)
+		{
+		RuleHdrTest* hdr_test = tests[h];
+
+		if ( hdr_test->pattern_rules )
+			state->hdr_tests.push_back(hdr_test);
+
+		if ( hdr_test->level <= RE_level )
+			AddEndpointMatchers(state, hdr_test);
+
+		for ( RuleHdrTest* child = hdr_test->child; child; child = child->sibling )
+			tests.push_back(child);
+		}
+
+	if ( num_gates )
+		state->opened_gates.resize(num_gates);
+
+	Match(state, Rule::PAYLOAD, (const u_char*)"", 0, true, false, false);
+
+	if ( chunk_size <= 0 )
+		chunk_size = data_len;
+
+	for ( int offset = 0; offset < data_len; offset += chunk_size )
+		Match(state, Rule::PAYLOAD, data + offset, std::min(chunk_size, data_len - offset),
+		      false, false, false);
+
+	// No FinishEndpoint(), as there's no connection to evaluate
+	// end-of-data conditions on.
+	delete state;
+
+	return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
 void RuleMatcher::Match(RuleEndpointState* state, Rule::PatternType type, const u_char* data,
                         int data_len, bool bol, bool eol, bool clear)
 	{
@@ -864,25 +1743,159 @@ void RuleMatcher::Match(RuleEndpointState* state, Rule::PatternType type, const
 		}
 #endif
 
+	// Whether this is the first chunk of payload after the BOL that
+	// InitEndpoint() sent, so that all matchers are still in their
+	// initial state.
+	bool first_chunk = (type == Rule::PAYLOAD && state->payload_size == 0 &&
+	                    data_len >= PrefixStateCache::PREFIX_LEN && ! clear);
+
+	// Whether to time this call for the rule profiles.
+	bool sample = (sig_profile_sample_interval > 0 &&
+	               ++match_calls % sig_profile_sample_interval == 0);
+
+	using clock = std::chrono::steady_clock;
+	clock::time_point start;
+
+	bytes_matched += data_len;
+
+	bool sized = false; // whether this sets the payload size
+
 	// Remember size of first non-null data.
 	if ( type == Rule::PAYLOAD )
 		{
 		bol = state->payload_size < 0;
 
 		if ( state->payload_size <= 0 && data_len )
+			{
 			state->payload_size = data_len;
+			sized = true;
+			}
 
 		else if ( state->payload_size < 0 )
 			state->payload_size = 0;
 		}
 
+	if ( clear )
+		{
+		for ( const auto& m : state->matchers )
+			{
+			if ( m->type != type )
+				continue;
+
+			// Starting over, so gated matchers wait for a literal again.
+			if ( m->gate >= 0 )
+				{
+				m->active = false;
+				state->opened_gates[m->gate] = false;
+				}
+
+			if ( m->retired )
+				{
+				m->retired = false;
+
+				if ( type == Rule::PAYLOAD )
+					++state->live_payload_matchers;
+				}
+			}
+
+		state->literal_tails[type].clear();
+
+		if ( type == Rule::PAYLOAD )
+			state->payload_offset = 0;
+		}
+
+	// Once the payload size is known, it's clear which rules can't match.
+	if ( type == Rule::PAYLOAD && state->payload_size > 0 && (sized || clear) )
+		RetireBySize(state);
+
+	if ( type == Rule::PAYLOAD && ! state->live_payload_matchers )
+		{
+		// Nothing left that could match.
+		state->payload_offset += data_len;
+		return;
+		}
+
+	bool scanned = false;
+
+	// The bytes kept from the previous chunk. They get replaced with
+	// this chunk's only once all matchers have seen them.
+	const auto& prev_tail = state->literal_tails[type];
+
 	// Feed data into all relevant matchers.
 	for ( const auto& m : state->matchers )
 		{
-		if ( m->type == type && m->state->Match((const u_char*)data, data_len, bol, eol, clear) )
+		if ( m->type != type || m->retired )
+			continue;
+
+		if ( type == Rule::PAYLOAD && state->payload_offset >= m->set->depth )
+			{
+			RetireMatcher(state, m);
+			continue;
+			}
+
+		if ( ! m->active )
+			{
+			if ( ! scanned )
+				{
+				ScanLiterals(state, type, prev_tail, data, data_len);
+				scanned = true;
+				}
+
+			if ( ! state->opened_gates[m->gate] )
+				continue;
+
+			// Start the DFA from scratch, including the bytes
+			// kept from the previous chunk as the literal may
+			// have begun there. This is equivalent to having
+			// fed all input since the patterns start with ".*"
+			// and the literal hasn't occurred earlier.
+			if ( type == Rule::PAYLOAD )
+				m->state->SetOffset(state->payload_offset - prev_tail.size());
+
+			m->state->Match(prev_tail.data(), prev_tail.size(), false, false, true);
+			m->active = true;
+			}
+
+		// A sampled call's time goes to the rules whose patterns it
+		// newly matches, so remember the matches so far.
+		AcceptingMatchSet before;
+
+		if ( sample )
+			{
+			before = m->state->AcceptedMatches();
+			start = clock::now();
+			}
+
+		// Payload match positions count from the start of the stream,
+		// as do the patterns' depths.
+		if ( type == Rule::PAYLOAD )
+			m->state->SetOffset(state->payload_offset);
+
+		bool matched;
+
+		if ( first_chunk && m->prefix_cache )
+			matched = MatchFirstChunk(m, data, data_len, eol);
+		else
+			matched = m->state->Match((const u_char*)data, data_len, bol, eol, clear);
+
+		if ( matched )
 			newmatch = true;
+
+		if ( sample )
+			AddMatchSample(before, m->state->AcceptedMatches(),
+			               std::chrono::duration<double>(clock::now() - start).count());
+
+		// The DFA is stuck if no pattern can match anymore.
+		if ( ! m->state->CurrentState() )
+			RetireMatcher(state, m);
 		}
 
+	if ( scanned )
+		UpdateLiteralTail(state, type, data, data_len);
+
+	if ( type == Rule::PAYLOAD )
+		state->payload_offset += data_len;
+
 	// If no new match found, we're already done.
 	if ( ! newmatch )
 		return;
@@ -947,13 +1960,146 @@ void RuleMatcher::Match(RuleEndpointState* state, Rule::PatternType type, const
 				}
 
 			DBG_LOG(DBG_RULES, "And has not already fired");
-			// Eval additional conditions.
-			if ( ! EvalRuleConditions(r, state, data, data_len, false) )
+
+			if ( ! state->analyzer )
+				{
+				// Benchmarking, without a connection for the
+				// conditions and actions.
+				state->matched_rules.push_back(r->Index());
+				++rule_profiles[r->Index()].hits;
 				continue;
+				}
+
+			if ( sample )
+				start = clock::now();
+
+			// Eval additional conditions.
+			if ( EvalRuleConditions(r, state, data, data_len, false) )
+				// Found a match.
+				ExecRuleActions(r, state, data, data_len, false);
+
+			if ( sample )
+				{
+				std::chrono::duration<double> secs = clock::now() - start;
+				rule_profiles[r->Index()].eval_time += secs.count() *
+				                                       sig_profile_sample_interval;
+				}
+			}
+		}
+	}
+
+void RuleMatcher::AddMatchSample(const AcceptingMatchSet& before, const AcceptingMatchSet& after,
+                                 double secs)
+	{
+	secs *= sig_profile_sample_interval;
+
+	std::vector<AcceptIdx> matched;
+
+	for ( const auto& [idx, pos] : after )
+		if ( before.find(idx) == before.end() )
+			matched.push_back(idx);
+
+	if ( matched.empty() )
+		{
+		unattributed_match_time += secs;
+		return;
+		}
+
+	for ( auto idx : matched )
+		rule_profiles[Rule::rule_table[idx - 1]->Index()].match_time += secs / matched.size();
+	}
 
-			// Found a match.
-			ExecRuleActions(r, state, data, data_len, false);
+void RuleMatcher::RetireMatcher(RuleEndpointState* state, RuleEndpointState::Matcher* m)
+	{
+	m->retired = true;
+	++matchers_retired;
+
+	if ( m->type == Rule::PAYLOAD )
+		--state->live_payload_matchers;
+	}
+
+void RuleMatcher::RetireBySize(RuleEndpointState* state)
+	{
+	for ( const auto& m : state->matchers )
+		{
+		if ( m->type != Rule::PAYLOAD || m->retired || m->set->sized_rules.empty() )
+			continue;
+
+		bool possible = false;
+
+		for ( const auto& r : m->set->sized_rules )
+			{
+			possible = std::all_of(r->conditions.begin(), r->conditions.end(),
+			                       [state, r](RuleCondition* c)
+			                       {
+				                       return ! dynamic_cast<RuleConditionPayloadSize*>(c) ||
+				                              c->DoMatch(r, state, nullptr, 0);
+			                       });
+
+			if ( possible )
+				break;
 			}
+
+		if ( ! possible )
+			RetireMatcher(state, m);
+		}
+	}
+
+bool RuleMatcher::MatchFirstChunk(RuleEndpointState::Matcher* m, const u_char* data,
+                                  int data_len, bool eol)
+	{
+	const int n = PrefixStateCache::PREFIX_LEN;
+	RE_Match_State* rms = m->state;
+	size_t old_matches = rms->AcceptedMatches().size();
+
+	if ( const auto* e = m->prefix_cache->Lookup(data) )
+		rms->Restore(e->state, e->matches, n);
+	else
+		{
+		rms->Match(data, n, false, false, false);
+		m->prefix_cache->Insert(data, rms->CurrentState(), rms->AcceptedMatches());
+		}
+
+	rms->MatchMore(data + n, data_len - n, eol);
+
+	return rms->AcceptedMatches().size() != old_matches;
+	}
+
+void RuleMatcher::ScanLiterals(RuleEndpointState* state, Rule::PatternType type,
+                               const std::basic_string<u_char>& tail, const u_char* data,
+                               int data_len)
+	{
+	const auto& prefilter = prefilters[type];
+
+	if ( ! tail.empty() )
+		{
+		// Look for literals starting in the tail. They can't reach
+		// further than MaxLength() - 1 bytes into the new data, and the
+		// tail is no longer than that either.
+		u_char buf[2 * LiteralPrefilter::MAX_LENGTH - 2];
+		size_t n = std::min(prefilter.MaxLength() - 1, static_cast<size_t>(data_len));
+		memcpy(buf, tail.data(), tail.size());
+		memcpy(buf + tail.size(), data, n);
+		prefilter.Scan(buf, tail.size() + n, &state->opened_gates);
+		}
+
+	prefilter.Scan(data, data_len, &state->opened_gates);
+	}
+
+void RuleMatcher::UpdateLiteralTail(RuleEndpointState* state, Rule::PatternType type,
+                                    const u_char* data, int data_len)
+	{
+	auto& tail = state->literal_tails[type];
+	size_t keep = prefilters[type].MaxLength() - 1;
+
+	if ( static_cast<size_t>(data_len) >= keep )
+		tail.assign(data + data_len - keep, keep);
+	else
+		{
+		tail.append(data, data_len);
+
+		if ( tail.size() > keep )
+			tail.erase(0, tail.size() - keep);
 		}
 	}
 
@@ -1055,6 +2201,7 @@ void RuleMatcher::ExecRuleActions(Rule* r, RuleEndpointState* state, const u_cha
 		return;
 
 	state->matched_rules.push_back(r->Index());
+	++rule_profiles[r->Index()].hits;
 
 	for ( const auto& action : r->actions )
 		action->DoAction(r, state, data, len);
@@ -1104,15 +2251,34 @@ void RuleMatcher::ClearEndpointState(RuleEndpointState* state)
 	ExecPureRules(state, true);
 
 	state->payload_size = -1;
+	state->payload_offset = 0;
+	state->live_payload_matchers = 0;
 
 	for ( const auto& matcher : state->matchers )
+		{
 		matcher->state->Clear();
+		matcher->active = (matcher->gate < 0);
+		matcher->retired = false;
+
+		if ( matcher->type == Rule::PAYLOAD )
+			++state->live_payload_matchers;
+		}
+
+	std::fill(state->opened_gates.begin(), state->opened_gates.end(), false);
+
+	for ( auto& tail : state->literal_tails )
+		tail.clear();
 	}
 
 void RuleMatcher::ClearFileMagicState(RuleFileMagicState* state) const
 	{
 	for ( const auto& matcher : state->matchers )
 		matcher->state->Clear();
+
+	for ( int idx : state->used )
+		state->anchored[idx]->Clear();
+
+	state->used.clear();
 	}
 
 void RuleMatcher::PrintDebug()
@@ -1178,33 +2344,49 @@ void RuleMatcher::GetStats(Stats* stats, RuleHdrTest* hdr_test)
 		stats->hits = 0;
 		stats->misses = 0;
 		stats->nfa_states = 0;
+		stats->prefix_hits = 0;
+		stats->prefix_misses = 0;
+		stats->bytes = bytes_matched;
+		stats->unattributed_time = unattributed_match_time;
+		stats->retired = matchers_retired;
 		hdr_test = root;
 		}
 
-	DFA_State_Cache::Stats cstats;
-
 	for ( int i = 0; i < Rule::TYPES; ++i )
-		{
 		for ( const auto& set : hdr_test->psets[i] )
-			{
-			assert(set->re);
+			AddSetStats(stats, set);
 
-			++stats->matchers;
-			set->re->DFA()->Cache()->GetStats(&cstats);
-
-			stats->dfa_states += cstats.dfa_states;
-			stats->computed += cstats.computed;
-			stats->mem += cstats.mem;
-			stats->hits += cstats.hits;
-			stats->misses += cstats.misses;
-			stats->nfa_states += cstats.nfa_states;
-			}
-		}
+	if ( hdr_test == root )
+		for ( const auto& set : magic_sets )
+			AddSetStats(stats, set);
 
 	for ( RuleHdrTest* h = hdr_test->child; h; h = h->sibling )
 		GetStats(stats, h);
 	}
 
+void RuleMatcher::AddSetStats(Stats* stats, const RuleHdrTest::PatternSet* set)
+	{
+	assert(set->re);
+
+	DFA_State_Cache::Stats cstats;
+
+	++stats->matchers;
+	set->re->DFA()->Cache()->GetStats(&cstats);
+
+	stats->dfa_states += cstats.dfa_states;
+	stats->computed += cstats.computed;
+	stats->mem += cstats.mem;
+	stats->hits += cstats.hits;
+	stats->misses += cstats.misses;
+	stats->nfa_states += cstats.nfa_states;
+
+	if ( set->prefix_cache )
+		{
+		stats->prefix_hits += set->prefix_cache->Hits();
+		stats->prefix_misses += set->prefix_cache->Misses();
+		}
+	}
+
 void RuleMatcher::DumpStats(File* f)
 	{
 	Stats stats;
@@ -1216,6 +2398,23 @@ void RuleMatcher::DumpStats(File* f)
 	                   stats.mem));
 	f->Write(util::fmt("%.6f DFA cache hits = %d; misses = %d\n", run_state::network_time,
 	                   stats.hits, stats.misses));
+	f->Write(util::fmt("%.6f prefix cache hits = %" PRIu64 "; misses = %" PRIu64 "\n",
+	                   run_state::network_time, stats.prefix_hits, stats.prefix_misses));
+	f->Write(util::fmt("%.6f bytes matched = %" PRIu64 "; matchers retired = %" PRIu64 "\n",
+	                   run_state::network_time, stats.bytes, stats.retired));
+	f->Write(util::fmt("%.6f unattributed match time = %.6f\n", run_state::network_time,
+	                   stats.unattributed_time));
+
+	for ( const auto& r : rules )
+		{
+		const auto& p = rule_profiles[r->Index()];
+
+		if ( p.hits || p.match_time > 0 || p.eval_time > 0 )
+			f->Write(util::fmt("%.6f rule %s: hits = %" PRIu64 "; match time = %.6f; "
+			                   "eval time = %.6f\n",
+			                   run_state::network_time, r->ID(), p.hits, p.match_time,
+			                   p.eval_time));
+		}
 
 	DumpStateStats(f, root);
 	}
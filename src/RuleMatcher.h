@@ -73,12 +73,101 @@ using maskedvalue_list = PList<MaskedValue>;
 using string_list = PList<char>;
 using bstr_list = PList<String>;
 
+// Remembers which DFA state, and which matches, the first bytes of an
+// endpoint's payload lead a pattern set to. Connections to the same service
+// often start with the same bytes; their endpoints can then pick up from
+// there instead of matching these bytes again. Entries are direct-mapped by
+// a hash of the prefix, so a colliding prefix replaces an older one.
+class PrefixStateCache
+	{
+public:
+	// Number of leading payload bytes making up a prefix.
+	static constexpr int PREFIX_LEN = 16;
+
+	struct Entry
+		{
+		std::basic_string<u_char> prefix; // empty if unused
+		DFA_State* state = nullptr; // nullptr if the DFA jammed
+		AcceptingMatchSet matches;
+		};
+
+	explicit PrefixStateCache(int size);
+	~PrefixStateCache();
+
+	// Returns the entry for the PREFIX_LEN bytes at prefix, or nullptr
+	// if there's none.
+	const Entry* Lookup(const u_char* prefix);
+
+	// Records what the PREFIX_LEN bytes at prefix lead to.
+	void Insert(const u_char* prefix, DFA_State* state, const AcceptingMatchSet& matches);
+
+	uint64_t Hits() const { return hits; }
+	uint64_t Misses() const { return misses; }
+
+private:
+	Entry& Slot(const u_char* prefix);
+
+	std::vector<Entry> entries;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	};
+
 // Get values from Bro's script-level variables.
 extern void id_to_maskedvallist(const char* id, maskedvalue_list* append_to,
                                 std::vector<IPPrefix>* prefix_vector = nullptr);
 extern char* id_to_str(const char* id);
 extern uint32_t id_to_uint(const char* id);
 
+// A multi-literal scanner used to hold off DFA matching for pattern sets
+// that cannot match before one of a set of literal strings has shown up in
+// the input. Candidate positions are found through a bitmap indexed by the
+// first two bytes of each literal, and then verified by direct comparison.
+// Where SSE2 or NEON is available and the literals start with only a few
+// distinct bytes, a vector comparison against those skips most positions
+// before even looking at the bitmap.
+class LiteralPrefilter
+	{
+public:
+	// Literals are cut off after this many bytes.
+	static constexpr size_t MAX_LENGTH = 32;
+
+	LiteralPrefilter();
+
+	// Registers a literal; a match of it will flag the given gate. If
+	// nocase is true, lit must be in lower case and input is compared
+	// case-insensitively. Literals need to have at least two bytes.
+	void Add(const std::string& lit, bool nocase, int gate);
+
+	bool Empty() const { return literals.empty(); }
+
+	// Length of the longest literal.
+	size_t MaxLength() const { return max_len; }
+
+	// Searches data for any of the literals, setting (*opened)[gate] for
+	// each one found. Gates already set are not searched for anymore.
+	void Scan(const u_char* data, int len, std::vector<bool>* opened) const;
+
+private:
+	struct Literal
+		{
+		std::string text;
+		bool nocase;
+		int gate;
+		};
+
+	static uint16_t Key(u_char c0, u_char c1) { return (uint16_t(c0) << 8) | c1; }
+
+	// Checks for literals starting at data[i], which needs to be followed
+	// by at least one more byte.
+	void ScanAt(const u_char* data, int len, int i, std::vector<bool>* opened) const;
+
+	std::vector<Literal> literals;
+	std::vector<u_char> first_bytes; // distinct first bytes, with case variants
+	std::vector<uint64_t> bigrams; // bitmap over Key()
+	std::map<uint16_t, std::vector<int>> candidates; // Key() -> literals
+	size_t max_len;
+	};
+
 class RuleHdrTest
 	{
 public:
@@ -135,10 +224,11 @@ private:
 
 	// The following are all set by RuleMatcher::BuildRulesTree().
 	friend class RuleMatcher;
+	friend class RuleEndpointState;
 
 	struct PatternSet
 		{
-		PatternSet() : re() { }
+		PatternSet() : re(), gate(-1), prefix_cache(), depth(UINT32_MAX) { }
 
 		// If we're above the 'RE_level' (see RuleMatcher), this
 		// expr contains all patterns on this node. If we're on
@@ -148,7 +238,24 @@ private:
 
 		// All the patterns and their rule indices.
 		string_list patterns;
-		int_list ids; // (only needed for debugging)
+		int_list ids; // (only needed for debugging and the DFA cache)
+
+		// If all patterns start with ".*" followed by a literal, index
+		// into the RuleMatcher's literal prefilter telling when this
+		// set needs to start matching; -1 otherwise.
+		int gate;
+
+		// For payload patterns that aren't gated, the states that
+		// payload prefixes have led to; nullptr if not used.
+		PrefixStateCache* prefix_cache;
+
+		// Payload offset up to which the patterns can match, as given
+		// by their depths; UINT32_MAX if there's no limit.
+		uint32_t depth;
+
+		// If each of the patterns' rules has a payload-size condition,
+		// those rules; empty otherwise.
+		std::vector<Rule*> sized_rules;
 		};
 
 	using pattern_set_list = PList<PatternSet>;
@@ -200,6 +307,11 @@ private:
 		{
 		RE_Match_State* state;
 		Rule::PatternType type;
+		int gate; // see RuleHdrTest::PatternSet
+		bool active; // false while still waiting for the gate to open
+		bool retired; // true once none of the patterns can match anymore
+		PrefixStateCache* prefix_cache; // see RuleHdrTest::PatternSet
+		const RuleHdrTest::PatternSet* set; // the set state matches
 		};
 
 	using matcher_list = PList<Matcher>;
@@ -220,7 +332,18 @@ private:
 	int payload_size;
 	bool is_orig;
 
+	// Payload bytes fed since the start or the last clearing, and the
+	// number of payload matchers not retired yet.
+	uint64_t payload_offset;
+	int live_payload_matchers;
+
 	int_list matched_rules; // Rules for which all conditions have matched
+
+	// Literal prefilter gates that have opened for this endpoint, and per
+	// pattern type the trailing bytes of the last chunk, in case a literal
+	// spans chunks.
+	std::vector<bool> opened_gates;
+	std::basic_string<u_char> literal_tails[Rule::TYPES];
 	};
 
 /**
@@ -245,6 +368,11 @@ private:
 
 	using matcher_list = PList<Matcher>;
 	matcher_list matchers;
+
+	// Matchers for RuleMatcher's indexed file magic sets, created on
+	// first use, and the ones used since the last clearing.
+	std::vector<RE_Match_State*> anchored;
+	std::set<int> used;
 	};
 
 // RuleMatcher is the main class which builds up the data structures
@@ -261,6 +389,17 @@ public:
 	// Parse the given files and built up data structures.
 	bool ReadFiles(const std::vector<std::string>& files);
 
+	// Wall-clock seconds spent in the phases of ReadFiles().
+	struct SetupTimes
+		{
+		double parse = 0.0;
+		double tree = 0.0;
+		double regex = 0.0;
+		double dfa = 0.0;
+		};
+
+	const SetupTimes& GetSetupTimes() const { return setup_times; }
+
 	/**
 	 * Inititialize a state object for matching file magic signatures.
 	 * @return A state object that can be used for file magic mime type
@@ -316,6 +455,15 @@ public:
 	// Reset the state of the pattern matcher for this endpoint.
 	void ClearEndpointState(RuleEndpointState* state);
 
+	// Feeds data through the signatures as the payload of a single
+	// endpoint, chunk_size bytes at a time (all at once if zero), for
+	// benchmarking them. With no packet to test, the endpoint gets the
+	// pattern sets of all header test nodes. With no connection, rules
+	// don't get their conditions evaluated or actions executed; a rule
+	// whose patterns have all matched counts as a hit. Returns the
+	// seconds spent.
+	double BenchmarkPayload(const u_char* data, int data_len, int chunk_size);
+
 	void PrintDebug();
 
 	// Interface to parser
@@ -340,8 +488,41 @@ public:
 		// # cache hits (sampled, multiply by MOVE_TO_FRONT_SAMPLE_SIZE)
 		unsigned int hits;
 		unsigned int misses; // # cache misses
+
+		// # payload prefixes found in and missing from the
+		// prefix state caches
+		uint64_t prefix_hits;
+		uint64_t prefix_misses;
+
+		uint64_t bytes; // # bytes fed into endpoint matching
+
+		// estimated seconds of pattern matching without a new match
+		double unattributed_time;
+
+		// # endpoint matchers retired before the end of the data
+		uint64_t retired;
+		};
+
+	// Per-rule counters for vetting signature sets. The times are
+	// estimates extrapolated from the Match() calls sampled as per
+	// sig_profile_sample_interval. The time of running a pattern set
+	// goes to the rules whose patterns newly matched in that call, if
+	// any, see Stats::unattributed_time.
+	struct RuleProfile
+		{
+		uint64_t hits = 0; // # times the rule fired
+		double match_time = 0.0; // running pattern sets up to its matches
+		double eval_time = 0.0; // evaluating its conditions and actions
 		};
 
+	// Returns the profile of a rule, or nullptr if it's not ours.
+	const RuleProfile* GetRuleProfile(const Rule* r) const
+		{
+		return r->Index() < rule_profiles.size() ? &rule_profiles[r->Index()] : nullptr;
+		}
+
+	const rule_list& Rules() const { return rules; }
+
 	Val* BuildRuleStateValue(const Rule* rule, const RuleEndpointState* state) const;
 
 	void GetStats(Stats* stats, RuleHdrTest* hdr_test = nullptr);
@@ -361,8 +542,52 @@ private:
 	void BuildRegEx(RuleHdrTest* hdr_test, string_list* exprs, int_list* ids);
 
 	// Build groups of regular epxressions.
-	void BuildPatternSets(RuleHdrTest::pattern_set_list* dst, const string_list& exprs,
-	                      const int_list& ids);
+	void BuildPatternSets(RuleHdrTest::pattern_set_list* dst, Rule::PatternType type,
+	                      const string_list& exprs, const int_list& ids);
+
+	// Builds the file magic pattern sets, indexing those patterns that
+	// need a certain byte at a fixed offset through magic_anchors.
+	void IndexFileMagic(RuleHdrTest::pattern_set_list* dst, const string_list& exprs,
+	                    const int_list& ids);
+
+	// Splits exprs into groups, leaving them to CompilePatternSets(). If
+	// gated is true, all exprs come with a required literal that's added
+	// to the prefilter.
+	void BuildPatternGroups(RuleHdrTest::pattern_set_list* dst, Rule::PatternType type,
+	                        const string_list& exprs, const int_list& ids, bool gated);
+
+	// Collects all pattern sets below the given node, plus the file
+	// magic ones indexed separately if hdr_test is the root.
+	void CollectPatternSets(RuleHdrTest* hdr_test,
+	                        std::vector<RuleHdrTest::PatternSet*>* sets) const;
+
+	// Compiles all pattern sets, or loads their DFAs from
+	// sig_dfa_cache_dir. The patterns get parsed on the main thread, as
+	// the RE parser is global. Building their DFAs, computing the states
+	// sig_precompute_dfa_states asks for and writing those that are
+	// complete to the cache then happens in parallel, using up to
+	// pattern_compile_threads threads. Adds the time spent parsing to
+	// setup_times.regex, the rest to setup_times.dfa.
+	void CompilePatternSets();
+
+	// Returns the DFA cache file for a pattern set.
+	std::string DFACachePath(const std::string& key) const;
+
+	// Feeds an endpoint's first chunk of payload into a matcher, taking
+	// the state its prefix leads to from the prefix cache if possible.
+	// Returns true if there are new matches.
+	bool MatchFirstChunk(RuleEndpointState::Matcher* m, const u_char* data, int data_len,
+	                     bool eol);
+
+	// Runs the literal prefilter for the given type over tail followed
+	// by data, updating the endpoint's opened gates.
+	void ScanLiterals(RuleEndpointState* state, Rule::PatternType type,
+	                  const std::basic_string<u_char>& tail, const u_char* data, int data_len);
+
+	// Keeps the trailing bytes of data that a literal spanning into the
+	// next chunk could start with.
+	void UpdateLiteralTail(RuleEndpointState* state, Rule::PatternType type, const u_char* data,
+	                       int data_len);
 
 	// Check an arbitrary rule if it's satisfied right now.
 	// eos signals end of stream
@@ -385,17 +610,72 @@ private:
 
 	void PrintTreeDebug(RuleHdrTest* node);
 
+	// Adds the DFA statistics of one pattern set.
+	static void AddSetStats(Stats* stats, const RuleHdrTest::PatternSet* set);
+
 	void DumpStateStats(File* f, RuleHdrTest* hdr_test);
 
+	// Checks whether all patterns of the rule have matched, given the
+	// position the match ended at; for payload that's within the stream.
 	static bool AllRulePatternsMatched(const Rule* r, MatchPos matchpos,
 	                                   const AcceptingMatchSet& ams);
 
+	// Splits the sampled time of running a pattern set across the
+	// profiles of the rules whose patterns it newly matched, given the
+	// matches before and after.
+	void AddMatchSample(const AcceptingMatchSet& before, const AcceptingMatchSet& after,
+	                    double secs);
+
+	// Adds the endpoint matchers for a header test node's pattern sets.
+	void AddEndpointMatchers(RuleEndpointState* state, RuleHdrTest* hdr_test);
+
+	// Returns the payload offset up to which the given pattern can
+	// match, its offset plus depth capped at UINT32_MAX.
+	static uint32_t PatternDepth(int id);
+
+	// Sets a pattern set's depth and sized rules.
+	static void SetMatchLimits(RuleHdrTest::PatternSet* set);
+
+	// Stops feeding data into an endpoint's matcher.
+	void RetireMatcher(RuleEndpointState* state, RuleEndpointState::Matcher* m);
+
+	// Retires the payload matchers of an endpoint whose rules all fail
+	// their payload-size conditions.
+	void RetireBySize(RuleEndpointState* state);
+
 	int RE_level;
 	bool has_non_file_magic_rule;
 	bool parse_error;
 	RuleHdrTest* root;
 	rule_list rules;
 	rule_dict rules_by_id;
+
+	LiteralPrefilter prefilters[Rule::TYPES];
+	int num_gates;
+
+	std::string dfa_cache_dir; // empty if not caching DFAs
+
+	SetupTimes setup_times;
+
+	// Indexed by Rule::Index().
+	std::vector<RuleProfile> rule_profiles;
+	uint64_t match_calls;
+	uint64_t bytes_matched;
+	double unattributed_match_time;
+	uint64_t matchers_retired;
+
+	// File magic pattern sets whose patterns all need a certain byte at
+	// a fixed offset, grouped by offset (in increasing order) and byte.
+	// A file's data only needs to run through the sets matching its
+	// bytes. Other file magic patterns are in root's sets as usual.
+	struct MagicAnchor
+		{
+		uint32_t offset;
+		std::vector<int> sets[256]; // indices into magic_sets
+		};
+
+	std::vector<MagicAnchor> magic_anchors;
+	RuleHdrTest::pattern_set_list magic_sets;
 	};
 
 // Keeps bi-directional matching-state.
@@ -379,7 +379,7 @@ void SampleLogger::SegmentProfile(const char* /* name */, const Location* /* loc
 	{
 	if ( load_sample )
 		event_mgr.Enqueue(load_sample, IntrusivePtr{NewRef{}, load_samples},
-		                  make_intrusive<IntervalVal>(dtime, Seconds), val_mgr->Int(dmem));
+		                  val_mgr->Interval(dtime), val_mgr->Int(dmem));
 	}
 
 void SegmentProfiler::Init()
@@ -25,6 +25,7 @@ const char* TimerNames[] = {
 	"ConnectionStatusUpdateTimer",
 	"ConnTupleWeirdTimer",
 	"DNSExpireTimer",
+	"EventRateTimer",
 	"FileAnalysisInactivityTimer",
 	"FlowWeirdTimer",
 	"FragTimer",
@@ -26,6 +26,7 @@ enum TimerType : uint8_t
 	TIMER_CONN_STATUS_UPDATE,
 	TIMER_CONN_TUPLE_WEIRD_EXPIRE,
 	TIMER_DNS_EXPIRE,
+	TIMER_EVENT_RATE,
 	TIMER_FILE_ANALYSIS_INACTIVITY,
 	TIMER_FLOW_WEIRD_EXPIRE,
 	TIMER_FRAG,
@@ -916,6 +916,10 @@ public:
 
 	bool def_coerce = false; // whether coercion's required
 
+	// Whether the field just gets a new, empty container, which a record
+	// can as well create once it's accessed.
+	bool lazy = false;
+
 	// For R_INIT_DIRECT/R_INIT_DIRECT_MANAGED:
 	ZVal direct_init;
 
@@ -928,9 +932,12 @@ public:
 	VectorTypePtr v_type; // for R_INIT_VECTOR
 	};
 
+unsigned int RecordType::fields_added = 0;
+
 RecordType::RecordType(type_decl_list* arg_types) : Type(TYPE_RECORD)
 	{
 	types = arg_types;
+	lazy_decided = fields_added;
 
 	if ( types )
 		{
@@ -1009,6 +1016,23 @@ void RecordType::AddField(unsigned int field, const TypeDecl* td)
 			init->init_type = FieldInit::R_INIT_DEF;
 			init->def_expr = def_expr;
 			init->def_type = def_expr->GetType();
+
+			// Defaults like set() or vector() don't depend on when
+			// they get evaluated.
+			switch ( def_expr->Tag() )
+				{
+				case detail::EXPR_TABLE_CONSTRUCTOR:
+				case detail::EXPR_SET_CONSTRUCTOR:
+				case detail::EXPR_VECTOR_CONSTRUCTOR:
+					{
+					auto op = static_cast<const detail::UnaryExpr*>(def_expr.get())->Op();
+					init->lazy = op->AsListExpr()->Exprs().empty();
+					break;
+					}
+
+				default:
+					break;
+				}
 			}
 		}
 
@@ -1033,6 +1057,13 @@ void RecordType::AddField(unsigned int field, const TypeDecl* td)
 			init->init_type = FieldInit::R_INIT_VECTOR;
 			init->v_type = cast_intrusive<VectorType>(type);
 			}
+
+		if ( init->init_type == FieldInit::R_INIT_RECORD )
+			// Creating the record later mustn't change what its
+			// own defaults evaluate to.
+			init->lazy = init->r_type->CreatesWithoutEval();
+		else
+			init->lazy = init->init_type != FieldInit::R_INIT_NONE;
 		}
 
 	field_inits.push_back(init);
@@ -1226,68 +1257,106 @@ void RecordType::AddFieldsDirectly(const type_decl_list& others, bool add_log_at
 		}
 
 	num_fields = types->length();
+	++fields_added;
 	}
 
-void RecordType::Create(std::vector<std::optional<ZVal>>& r) const
+void RecordType::Create(ZVal* r, uint8_t* flags) const
 	{
+	if ( lazy_decided != fields_added )
+		UpdateLazyFields();
+
 	int n = NumFields();
 
 	for ( int i = 0; i < n; ++i )
 		{
-		auto& init = field_inits[i];
+		if ( field_inits[i]->lazy )
+			flags[i] = FIELD_PRESENT | FIELD_LAZY;
+		else
+			flags[i] = InitField(i, r[i]) ? FIELD_PRESENT : 0;
+		}
+	}
 
-		ZVal r_i;
+bool RecordType::CreatesWithoutEval() const
+	{
+	if ( lazy_decided != fields_added )
+		UpdateLazyFields();
 
-		switch ( init->init_type )
-			{
-			case FieldInit::R_INIT_NONE:
-				r.push_back(std::nullopt);
-				continue;
+	for ( const auto& init : field_inits )
+		if ( ! init->lazy && (init->init_type == FieldInit::R_INIT_DEF ||
+		                      init->init_type == FieldInit::R_INIT_RECORD) )
+			return false;
 
-			case FieldInit::R_INIT_DIRECT:
-				r_i = init->direct_init;
-				break;
+	return true;
+	}
 
-			case FieldInit::R_INIT_DIRECT_MANAGED:
-				r_i = init->direct_init;
-				zeek::Ref(r_i.ManagedVal());
-				break;
+void RecordType::UpdateLazyFields() const
+	{
+	lazy_decided = fields_added;
 
-			case FieldInit::R_INIT_DEF:
-				{
-				auto v = init->def_expr->Eval(nullptr);
-				if ( v )
-					{
-					const auto& t = init->def_type;
+	for ( auto init : field_inits )
+		if ( init->init_type == FieldInit::R_INIT_RECORD )
+			init->lazy = init->r_type->CreatesWithoutEval();
+	}
+
+ZVal RecordType::CreateField(int field) const
+	{
+	ZVal r;
+	InitField(field, r);
+	return r;
+	}
 
-					if ( init->def_coerce )
-						{
-						auto rt = cast_intrusive<RecordType>(t);
-						v = v->AsRecordVal()->CoerceTo(rt);
-						}
+bool RecordType::InitField(int field, ZVal& r_i) const
+	{
+	auto& init = field_inits[field];
 
-					r_i = ZVal(v, t);
-					}
-				else
-					reporter->Error("failed &default in record creation");
-				}
-				break;
+	switch ( init->init_type )
+		{
+		case FieldInit::R_INIT_NONE:
+			return false;
 
-			case FieldInit::R_INIT_RECORD:
-				r_i = ZVal(new RecordVal(init->r_type));
-				break;
+		case FieldInit::R_INIT_DIRECT:
+			r_i = init->direct_init;
+			break;
 
-			case FieldInit::R_INIT_TABLE:
-				r_i = ZVal(new TableVal(init->t_type, init->attrs));
-				break;
+		case FieldInit::R_INIT_DIRECT_MANAGED:
+			r_i = init->direct_init;
+			zeek::Ref(r_i.ManagedVal());
+			break;
 
-			case FieldInit::R_INIT_VECTOR:
-				r_i = ZVal(new VectorVal(init->v_type));
-				break;
+		case FieldInit::R_INIT_DEF:
+			{
+			auto v = init->def_expr->Eval(nullptr);
+			if ( v )
+				{
+				const auto& t = init->def_type;
+
+				if ( init->def_coerce )
+					{
+					auto rt = cast_intrusive<RecordType>(t);
+					v = v->AsRecordVal()->CoerceTo(rt);
+					}
+
+				r_i = ZVal(v, t);
+				}
+			else
+				reporter->Error("failed &default in record creation");
 			}
+			break;
 
-		r.push_back(r_i);
+		case FieldInit::R_INIT_RECORD:
+			r_i = ZVal(new RecordVal(init->r_type));
+			break;
+
+		case FieldInit::R_INIT_TABLE:
+			r_i = ZVal(new TableVal(init->t_type, init->attrs));
+			break;
+
+		case FieldInit::R_INIT_VECTOR:
+			r_i = ZVal(new VectorVal(init->v_type));
+			break;
 		}
+
+	return true;
 	}
 
 void RecordType::DescribeFields(ODesc* d) const
@@ -652,12 +652,26 @@ public:
 
 	void AddFieldsDirectly(const type_decl_list& types, bool add_log_attr = false);
 
+	// Flags describing the state of a field of a record instance.
+	static constexpr uint8_t FIELD_PRESENT = 0x1; // the field has a value
+	static constexpr uint8_t FIELD_LAZY = 0x2; // ... that's yet to be created
+
 	/**
-	 *
 	 * Populates a new instance of the record with its initial values.
-	 * @param r  The record's underlying value vector.
+	 * Fields that start out as a new, empty record, table, set or vector
+	 * are left for the instance to create on first access: they're
+	 * flagged as both present and lazy.
+	 * @param r  The record's underlying values, one default ZVal per field.
+	 * @param flags  The record's field flags, one per field.
+	 */
+	void Create(ZVal* r, uint8_t* flags) const;
+
+	/**
+	 * Returns the initial value of a field that Create() left to be
+	 * created lazily.
+	 * @param field  The field's offset.
 	 */
-	void Create(std::vector<std::optional<ZVal>>& r) const;
+	ZVal CreateField(int field) const;
 
 	void Describe(ODesc* d) const override;
 	void DescribeReST(ODesc* d, bool roles_only = false) const override;
@@ -683,6 +697,24 @@ protected:
 
 	void AddField(unsigned int field, const TypeDecl* td);
 
+	// Sets r to the initial value of the given field. Returns false if
+	// the field starts out without one.
+	bool InitField(int field, ZVal& r) const;
+
+	// Whether creating an instance doesn't evaluate any &default
+	// expressions, so that it can as well happen later.
+	bool CreatesWithoutEval() const;
+
+	// Re-decides which record-valued fields can get created lazily, as
+	// record types may have gained fields with &default expressions since.
+	void UpdateLazyFields() const;
+
+	// The value of fields_added when the laziness of fields was decided.
+	mutable unsigned int lazy_decided = 0;
+
+	// Counts the additions of fields to existing record types.
+	static unsigned int fields_added;
+
 	// Maps each field to how to initialize it.  Uses pointers due to
 	// keeping the FieldInit definition private to Type.cc (see above).
 	std::vector<FieldInit*> field_inits;
@@ -1035,6 +1067,7 @@ extern zeek::OpaqueTypePtr bloomfilter_type;
 extern zeek::OpaqueTypePtr x509_opaque_type;
 extern zeek::OpaqueTypePtr ocsp_resp_opaque_type;
 extern zeek::OpaqueTypePtr paraglob_type;
+extern zeek::OpaqueTypePtr pattern_set_type;
 extern zeek::OpaqueTypePtr int_counter_metric_type;
 extern zeek::OpaqueTypePtr int_counter_metric_family_type;
 extern zeek::OpaqueTypePtr dbl_counter_metric_type;
@@ -11,7 +11,9 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <set>
 
 #include "zeek/Attr.h"
@@ -1427,7 +1429,6 @@ void TableVal::Init(TableTypePtr t)
 	table_type = std::move(t);
 	expire_func = nullptr;
 	expire_time = nullptr;
-	expire_iterator = nullptr;
 	timer = nullptr;
 	def_val = nullptr;
 
@@ -1449,13 +1450,12 @@ TableVal::~TableVal()
 	delete table_hash;
 	delete table_val;
 	delete subnets;
-	delete expire_iterator;
 	}
 
 void TableVal::RemoveAll()
 	{
-	delete expire_iterator;
-	expire_iterator = nullptr;
+	expire_buckets.clear();
+	expire_stale_refs = 0;
 	// Here we take the brute force approach.
 	delete table_val;
 	table_val = new PDict<TableEntryVal>;
@@ -1491,6 +1491,21 @@ void TableVal::SetAttrs(detail::AttributesPtr a)
 	if ( ! attrs )
 		return;
 
+	bool want_fast_hash = attrs->Find(detail::ATTR_FAST_HASH) != nullptr;
+
+	if ( want_fast_hash != fast_hash )
+		{
+		if ( table_val->Length() > 0 )
+			{
+			// Rehash the entries already present.
+			auto state = DumpTableState();
+			fast_hash = want_fast_hash;
+			RebuildTable(std::move(state));
+			}
+		else
+			fast_hash = want_fast_hash;
+		}
+
 	CheckExpireAttr(detail::ATTR_EXPIRE_READ);
 	CheckExpireAttr(detail::ATTR_EXPIRE_WRITE);
 	CheckExpireAttr(detail::ATTR_EXPIRE_CREATE);
@@ -1537,6 +1552,11 @@ void TableVal::CheckExpireAttr(detail::AttrTag at)
 			return;
 			}
 
+		// Entries that predate the attribute, e.g. with a redef of
+		// it, have no references in the buckets yet.
+		if ( table_val->Length() > 0 )
+			RebuildExpireBuckets();
+
 		if ( timer )
 			detail::timer_mgr->Cancel(timer);
 
@@ -1594,6 +1614,19 @@ bool TableVal::Assign(ValPtr index, std::unique_ptr<detail::HashKey> k, ValPtr n
 	if ( old_entry_val && attrs && attrs->Find(detail::ATTR_EXPIRE_CREATE) )
 		new_entry_val->SetExpireAccess(old_entry_val->ExpireAccessTime());
 
+	if ( expire_time )
+		{
+		// The key already has a reference if it's in the table.
+		if ( old_entry_val )
+			new_entry_val->expire_serial = old_entry_val->expire_serial;
+		else
+			{
+			new_entry_val->expire_serial = ++expire_serials;
+			AddExpireRef({uint32_t(k_copy.Hash()), new_entry_val->expire_serial},
+			             new_entry_val->ExpireAccessTime() + expire_timeout);
+			}
+		}
+
 	Modified();
 
 	if ( change_func || (broker_forward && ! broker_store.empty()) )
@@ -1644,7 +1677,7 @@ bool TableVal::AddTo(Val* val, bool is_first_init, bool propagate_ops) const
 
 	for ( const auto& tble : *table_val )
 		{
-		auto k = tble.GetHashKey();
+		auto k = KeyFor(*t, tble.GetHashKey());
 		auto* v = tble.GetValue<TableEntryVal*>();
 
 		if ( is_first_init && t->AsTable()->Lookup(k.get()) )
@@ -1688,12 +1721,10 @@ bool TableVal::RemoveFrom(Val* val) const
 
 	for ( const auto& tble : *table_val )
 		{
-		// Not sure that this is 100% sound, since the HashKey
-		// comes from one table but is being used in another.
-		// OTOH, they are both the same type, so as long as
-		// we don't have hash keys that are keyed per dictionary,
-		// it should work ...
-		auto k = tble.GetHashKey();
+		// The HashKey comes from one table but is being used in
+		// another. They are both the same type, so the key bytes
+		// match, and KeyFor() takes care of their hashes.
+		auto k = KeyFor(*t, tble.GetHashKey());
 		t->Remove(*k);
 		}
 
@@ -1704,6 +1735,7 @@ TableValPtr TableVal::Intersection(const TableVal& tv) const
 	{
 	auto result = make_intrusive<TableVal>(table_type);
 
+	const TableVal* v0 = this;
 	const PDict<TableEntryVal>* t0 = table_val;
 	const PDict<TableEntryVal>* t1 = tv.AsTable();
 
@@ -1713,6 +1745,7 @@ TableValPtr TableVal::Intersection(const TableVal& tv) const
 		const PDict<TableEntryVal>* tmp = t1;
 		t1 = t0;
 		t0 = tmp;
+		v0 = &tv;
 		}
 
 	const PDict<TableEntryVal>* tbl = AsTable();
@@ -1721,9 +1754,10 @@ TableValPtr TableVal::Intersection(const TableVal& tv) const
 		auto k = tble.GetHashKey();
 
 		// Here we leverage the same assumption about consistent
-		// hashes as in TableVal::RemoveFrom above.
-		if ( t0->Lookup(k.get()) )
-			result->table_val->Insert(k.get(), new TableEntryVal(nullptr));
+		// keys as in TableVal::RemoveFrom above.
+		if ( t0->Lookup(KeyFor(*v0, tble.GetHashKey()).get()) )
+			result->table_val->Insert(KeyFor(*result, std::move(k)).get(),
+			                          new TableEntryVal(nullptr));
 		}
 
 	return result;
@@ -1739,10 +1773,10 @@ bool TableVal::EqualTo(const TableVal& tv) const
 
 	for ( const auto& tble : *t0 )
 		{
-		auto k = tble.GetHashKey();
+		auto k = KeyFor(tv, tble.GetHashKey());
 
 		// Here we leverage the same assumption about consistent
-		// hashes as in TableVal::RemoveFrom above.
+		// keys as in TableVal::RemoveFrom above.
 		if ( ! t1->Lookup(k.get()) )
 			return false;
 		}
@@ -1760,10 +1794,10 @@ bool TableVal::IsSubsetOf(const TableVal& tv) const
 
 	for ( const auto& tble : *t0 )
 		{
-		auto k = tble.GetHashKey();
+		auto k = KeyFor(tv, tble.GetHashKey());
 
 		// Here we leverage the same assumption about consistent
-		// hashes as in TableVal::RemoveFrom above.
+		// keys as in TableVal::RemoveFrom above.
 		if ( ! t1->Lookup(k.get()) )
 			return false;
 		}
@@ -1928,28 +1962,57 @@ const ValPtr& TableVal::Find(const ValPtr& index)
 
 	if ( table_val->Length() > 0 )
 		{
-		auto k = MakeHashKey(*index);
+		TableEntryVal* v = LookupEntry(*index);
 
-		if ( k )
+		if ( v )
 			{
-			TableEntryVal* v = table_val->Lookup(k.get());
-
-			if ( v )
-				{
-				if ( attrs && attrs->Find(detail::ATTR_EXPIRE_READ) )
-					v->SetExpireAccess(run_state::network_time);
+			if ( attrs && attrs->Find(detail::ATTR_EXPIRE_READ) )
+				v->SetExpireAccess(run_state::network_time);
 
-				if ( v->GetVal() )
-					return v->GetVal();
+			if ( v->GetVal() )
+				return v->GetVal();
 
-				return val_mgr->True();
-				}
+			return val_mgr->True();
 			}
 		}
 
 	return Val::nil;
 	}
 
+TableEntryVal* TableVal::LookupEntry(const Val& index)
+	{
+	alignas(double) char buf[detail::CompositeHash::KEY_BUFFER_SIZE];
+
+	if ( size_t size = table_hash->WriteKey(index, true, buf, sizeof(buf)) )
+		{
+		detail::HashKey k(buf, size, KeyHash(buf, size), true);
+		return table_val->Lookup(&k);
+		}
+
+	auto k = MakeHashKey(index);
+	return k ? table_val->Lookup(k.get()) : nullptr;
+	}
+
+detail::hash_t TableVal::KeyHash(const void* key, size_t size) const
+	{
+	if ( ! fast_hash )
+		return detail::HashKey::HashBytes(key, size);
+
+	// The table's entries only keep the lower 32 bits of the hash, and
+	// HashKey computes a zero hash anew with HashBytes(), so avoid those.
+	detail::hash_t h = detail::KeyedHash::FastHash64(key, size);
+	return uint32_t(h) ? h : h | 1;
+	}
+
+std::unique_ptr<detail::HashKey> TableVal::KeyFor(const TableVal& tv,
+                                                  std::unique_ptr<detail::HashKey> k) const
+	{
+	if ( tv.fast_hash == fast_hash )
+		return k;
+
+	return std::make_unique<detail::HashKey>(k->Key(), k->Size(), tv.KeyHash(k->Key(), k->Size()));
+	}
+
 ValPtr TableVal::FindOrDefault(const ValPtr& index)
 	{
 	if ( auto rval = Find(index) )
@@ -2018,14 +2081,7 @@ bool TableVal::UpdateTimestamp(Val* index)
 	if ( subnets )
 		v = (TableEntryVal*)subnets->Lookup(index);
 	else
-		{
-		auto k = MakeHashKey(*index);
-
-		if ( ! k )
-			return false;
-
-		v = table_val->Lookup(k.get());
-		}
+		v = LookupEntry(*index);
 
 	if ( ! v )
 		return false;
@@ -2228,8 +2284,13 @@ ValPtr TableVal::Remove(const Val& index, bool broker_forward, bool* iterators_i
 	ValPtr va;
 
 	if ( v )
+		{
 		va = v->GetVal() ? v->GetVal() : IntrusivePtr{NewRef{}, this};
 
+		if ( v->expire_serial )
+			++expire_stale_refs;
+		}
+
 	if ( subnets && ! subnets->Remove(&index) )
 		reporter->InternalWarning("index not in prefix table");
 
@@ -2256,8 +2317,13 @@ ValPtr TableVal::Remove(const detail::HashKey& k, bool* iterators_invalidated)
 	ValPtr va;
 
 	if ( v )
+		{
 		va = v->GetVal() ? v->GetVal() : IntrusivePtr{NewRef{}, this};
 
+		if ( v->expire_serial )
+			++expire_stale_refs;
+		}
+
 	if ( subnets )
 		{
 		auto index = table_hash->RecoverVals(k);
@@ -2527,6 +2593,43 @@ void TableVal::InitTimer(double delay)
 	detail::timer_mgr->Add(timer);
 	}
 
+// Expiration buckets span table_expire_interval, the time between
+// expiration runs.
+static int64_t expire_bucket(double t)
+	{
+	double width = detail::table_expire_interval > 0 ? detail::table_expire_interval : 1.0;
+	return static_cast<int64_t>(t / width);
+	}
+
+void TableVal::AddExpireRef(ExpireRef ref, double due)
+	{
+	expire_buckets[expire_bucket(due)].push_back(ref);
+	}
+
+TableEntryVal* TableVal::LookupExpireRef(const ExpireRef& ref,
+                                         std::unique_ptr<detail::HashKey>* k) const
+	{
+	auto is_ref = [&ref](const void* v)
+	{
+		return static_cast<const TableEntryVal*>(v)->expire_serial == ref.serial;
+	};
+
+	return static_cast<TableEntryVal*>(table_val->LookupByHash(ref.hash, is_ref, k));
+	}
+
+void TableVal::RebuildExpireBuckets()
+	{
+	expire_buckets.clear();
+	expire_stale_refs = 0;
+
+	for ( const auto& tble : *table_val )
+		{
+		auto v = tble.GetValue<TableEntryVal*>();
+		v->expire_serial = ++expire_serials;
+		AddExpireRef({tble.hash, v->expire_serial}, v->ExpireAccessTime() + expire_timeout);
+		}
+	}
+
 void TableVal::DoExpire(double t)
 	{
 	if ( ! type )
@@ -2535,23 +2638,58 @@ void TableVal::DoExpire(double t)
 	double timeout = GetExpireTime();
 
 	if ( timeout < 0 )
+		{
 		// Skip in case of unset/invalid expiration value. If it's an
 		// error, it has been reported already.
+		expire_buckets.clear();
+		expire_stale_refs = 0;
 		return;
+		}
 
-	if ( ! expire_iterator )
+	if ( timeout != expire_timeout )
 		{
-		auto it = table_val->begin_robust();
-		expire_iterator = new RobustDictIterator(std::move(it));
+		// With a shorter timeout, entries may be due before their
+		// buckets. With a longer one, they just move on later.
+		bool shorter = timeout < expire_timeout;
+		expire_timeout = timeout;
+
+		if ( shorter )
+			RebuildExpireBuckets();
 		}
 
 	bool modified = false;
+	int64_t now = expire_bucket(t);
+
+	// References to entries that aren't due yet, to file anew once done
+	// so that they don't come up again in this run.
+	std::vector<std::pair<ExpireRef, double>> not_due;
 
-	for ( int i = 0;
-	      i < zeek::detail::table_incremental_step && *expire_iterator != table_val->end_robust();
-	      ++i, ++(*expire_iterator) )
+	for ( int i = 0; i < zeek::detail::table_incremental_step; )
 		{
-		auto v = (*expire_iterator)->GetValue<TableEntryVal*>();
+		auto b = expire_buckets.begin();
+
+		if ( b == expire_buckets.end() || b->first > now )
+			break;
+
+		if ( b->second.empty() )
+			{
+			expire_buckets.erase(b);
+			continue;
+			}
+
+		auto ref = b->second.back();
+		b->second.pop_back();
+		++i;
+
+		auto v = LookupExpireRef(ref);
+
+		if ( ! v )
+			{
+			// Removed since.
+			if ( expire_stale_refs > 0 )
+				--expire_stale_refs;
+			continue;
+			}
 
 		if ( v->ExpireAccessTime() == 0 )
 			{
@@ -2560,72 +2698,82 @@ void TableVal::DoExpire(double t)
 			// also when bro_start_network_time hasn't been initialized
 			// (e.g. before first packet).  The expire_access_time is
 			// correct, so we just need to wait.
+			not_due.emplace_back(ref, t);
+			continue;
 			}
 
-		else if ( v->ExpireAccessTime() + timeout < t )
+		if ( v->ExpireAccessTime() + timeout >= t )
 			{
-			auto k = (*expire_iterator)->GetHashKey();
-			ListValPtr idx = nullptr;
+			// Accessed since the reference was filed.
+			not_due.emplace_back(ref, v->ExpireAccessTime() + timeout);
+			continue;
+			}
 
-			if ( expire_func )
-				{
-				idx = RecreateIndex(*k);
-				double secs = CallExpireFunc(idx);
+		std::unique_ptr<detail::HashKey> k;
+		LookupExpireRef(ref, &k);
+		ListValPtr idx = nullptr;
 
-				// It's possible that the user-provided
-				// function modified or deleted the table
-				// value, so look it up again.
-				v = table_val->Lookup(k.get());
+		if ( expire_func )
+			{
+			idx = RecreateIndex(*k);
+			double secs = CallExpireFunc(idx);
 
-				if ( ! v )
-					{ // user-provided function deleted it
-					if ( ! expire_iterator )
-						// Entire table got dropped (e.g. clear_table() / RemoveAll())
-						break;
+			// It's possible that the user-provided
+			// function modified or deleted the table
+			// value, so look it up again.
+			v = LookupExpireRef(ref);
 
-					continue;
-					}
-
-				if ( secs > 0 )
-					{
-					// User doesn't want us to expire
-					// this now.
-					v->SetExpireAccess(run_state::network_time - timeout + secs);
-					continue;
-					}
+			if ( ! v )
+				{
+				// User-provided function deleted it.
+				if ( expire_stale_refs > 0 )
+					--expire_stale_refs;
+				continue;
 				}
 
-			if ( subnets )
+			if ( secs > 0 )
 				{
-				if ( ! idx )
-					idx = RecreateIndex(*k);
-				if ( ! subnets->Remove(idx.get()) )
-					reporter->InternalWarning("index not in prefix table");
+				// User doesn't want us to expire
+				// this now.
+				v->SetExpireAccess(run_state::network_time - timeout + secs);
+				not_due.emplace_back(ref, v->ExpireAccessTime() + timeout);
+				continue;
 				}
+			}
 
-			table_val->RemoveEntry(k.get());
-			if ( change_func )
-				{
-				if ( ! idx )
-					idx = RecreateIndex(*k);
+		if ( subnets )
+			{
+			if ( ! idx )
+				idx = RecreateIndex(*k);
+			if ( ! subnets->Remove(idx.get()) )
+				reporter->InternalWarning("index not in prefix table");
+			}
 
-				CallChangeFunc(idx, v->GetVal(), ELEMENT_EXPIRED);
-				}
+		table_val->RemoveEntry(k.get());
+		if ( change_func )
+			{
+			if ( ! idx )
+				idx = RecreateIndex(*k);
 
-			delete v;
-			modified = true;
+			CallChangeFunc(idx, v->GetVal(), ELEMENT_EXPIRED);
 			}
+
+		delete v;
+		modified = true;
 		}
 
+	for ( const auto& [ref, due] : not_due )
+		AddExpireRef(ref, due);
+
+	if ( expire_stale_refs > table_val->Length() )
+		// Don't let references to removed entries pile up.
+		RebuildExpireBuckets();
+
 	if ( modified )
 		Modified();
 
-	if ( ! expire_iterator || (*expire_iterator) == table_val->end_robust() )
-		{
-		delete expire_iterator;
-		expire_iterator = nullptr;
+	if ( expire_buckets.empty() || expire_buckets.begin()->first > now )
 		InitTimer(zeek::detail::table_expire_interval);
-		}
 	else
 		InitTimer(zeek::detail::table_expire_delay);
 	}
@@ -2742,10 +2890,13 @@ ValPtr TableVal::DoClone(CloneState* state)
 		}
 
 	tv->attrs = attrs;
+	tv->fast_hash = fast_hash;
 
 	if ( expire_time )
 		{
 		tv->expire_time = expire_time;
+		tv->expire_timeout = expire_timeout;
+		tv->RebuildExpireBuckets();
 
 		// As network_time is not necessarily initialized yet, we set
 		// a timer which fires immediately.
@@ -2783,7 +2934,12 @@ unsigned int TableVal::MemoryAllocation() const
 
 std::unique_ptr<detail::HashKey> TableVal::MakeHashKey(const Val& index) const
 	{
-	return table_hash->MakeHashKey(index, true);
+	auto k = table_hash->MakeHashKey(index, true);
+
+	if ( k && fast_hash )
+		k->SetHash(KeyHash(k->Key(), k->Size()));
+
+	return k;
 	}
 
 void TableVal::SaveParseTimeTableState(RecordType* rt)
@@ -2849,8 +3005,7 @@ RecordVal::RecordVal(RecordTypePtr t, bool init_fields) : Val(t), is_managed(t->
 
 	int n = rt->NumFields();
 
-	record_val = new std::vector<std::optional<ZVal>>;
-	record_val->reserve(n);
+	Reserve(n);
 
 	if ( run_state::is_parsing )
 		parse_time_records[rt.get()].emplace_back(NewRef{}, this);
@@ -2859,7 +3014,8 @@ RecordVal::RecordVal(RecordTypePtr t, bool init_fields) : Val(t), is_managed(t->
 		{
 		try
 			{
-			rt->Create(*record_val);
+			rt->Create(record_val, FieldFlags());
+			num_fields = n;
 			}
 		catch ( InterpreterException& e )
 			{
@@ -2872,13 +3028,30 @@ RecordVal::RecordVal(RecordTypePtr t, bool init_fields) : Val(t), is_managed(t->
 
 RecordVal::~RecordVal()
 	{
-	auto n = record_val->size();
+	for ( unsigned int i = 0; i < num_fields; ++i )
+		if ( HasField(i) && IsManaged(i) && ! IsLazy(i) )
+			ZVal::DeleteManagedType(record_val[i]);
+
+	::operator delete(record_val);
+	}
+
+void RecordVal::Reserve(unsigned int n)
+	{
+	auto vals = static_cast<ZVal*>(::operator new(n * (sizeof(ZVal) + 1)));
+	auto flags = reinterpret_cast<uint8_t*>(vals + n);
+
+	if ( record_val )
+		{
+		std::uninitialized_copy_n(record_val, num_fields, vals);
+		std::copy_n(FieldFlags(), num_fields, flags);
+		::operator delete(record_val);
+		}
 
-	for ( unsigned int i = 0; i < n; ++i )
-		if ( HasField(i) && IsManaged(i) )
-			ZVal::DeleteManagedType(*(*record_val)[i]);
+	std::uninitialized_fill_n(vals + num_fields, n - num_fields, ZVal());
+	std::fill_n(flags + num_fields, n - num_fields, 0);
 
-	delete record_val;
+	record_val = vals;
+	max_fields = n;
 	}
 
 ValPtr RecordVal::SizeVal() const
@@ -2893,7 +3066,9 @@ void RecordVal::Assign(int field, ValPtr new_val)
 		DeleteFieldIfManaged(field);
 
 		auto t = rt->GetFieldType(field);
-		(*record_val)[field] = ZVal(new_val, t);
+		record_val[field] = ZVal(new_val, t);
+		MarkPresent(field);
+
 		Modified();
 		}
 	else
@@ -2904,10 +3079,11 @@ void RecordVal::Remove(int field)
 	{
 	if ( HasField(field) )
 		{
-		if ( IsManaged(field) )
-			ZVal::DeleteManagedType(*(*record_val)[field]);
+		if ( IsManaged(field) && ! IsLazy(field) )
+			ZVal::DeleteManagedType(record_val[field]);
 
-		(*record_val)[field] = std::nullopt;
+		record_val[field] = ZVal();
+		FieldFlags()[field] = 0;
 
 		Modified();
 		}
@@ -2923,6 +3099,12 @@ ValPtr RecordVal::GetFieldOrDefault(int field) const
 	return GetType()->AsRecordType()->FieldDefault(field);
 	}
 
+void RecordVal::CreateLazyField(unsigned int field) const
+	{
+	record_val[field] = rt->CreateField(field);
+	FieldFlags()[field] = RecordType::FIELD_PRESENT;
+	}
+
 void RecordVal::ResizeParseTimeRecords(RecordType* revised_rt)
 	{
 	auto it = parse_time_records.find(revised_rt);
@@ -2939,6 +3121,8 @@ void RecordVal::ResizeParseTimeRecords(RecordType* revised_rt)
 
 		if ( required_length > current_length )
 			{
+			rv->Reserve(required_length);
+
 			for ( auto i = current_length; i < required_length; ++i )
 				rv->AppendField(revised_rt->FieldDefault(i), revised_rt->GetFieldType(i));
 			}
@@ -3044,7 +3228,7 @@ TableValPtr RecordVal::GetRecordFieldsVal() const
 
 void RecordVal::Describe(ODesc* d) const
 	{
-	auto n = record_val->size();
+	auto n = num_fields;
 
 	if ( d->IsBinary() || d->IsPortable() )
 		{
@@ -3080,7 +3264,7 @@ void RecordVal::Describe(ODesc* d) const
 
 void RecordVal::DescribeReST(ODesc* d) const
 	{
-	auto n = record_val->size();
+	auto n = num_fields;
 	auto rt = GetType()->AsRecordType();
 
 	d->Add("{");
@@ -3120,6 +3304,15 @@ ValPtr RecordVal::DoClone(CloneState* state)
 	int n = NumFields();
 	for ( auto i = 0; i < n; ++i )
 		{
+		if ( IsLazy(i) )
+			{
+			// Nothing to copy yet, so leave it to the clone to
+			// create its own.
+			rv->AppendField(nullptr, rt->GetFieldType(i));
+			rv->FieldFlags()[i] = RecordType::FIELD_PRESENT | RecordType::FIELD_LAZY;
+			continue;
+			}
+
 		auto f_i = GetField(i);
 		auto v = f_i ? f_i->Clone(state) : nullptr;
 		rv->AppendField(std::move(v), rt->GetFieldType(i));
@@ -3135,6 +3328,9 @@ unsigned int RecordVal::MemoryAllocation() const
 	int n = NumFields();
 	for ( auto i = 0; i < n; ++i )
 		{
+		if ( IsLazy(i) )
+			continue;
+
 		auto f_i = GetField(i);
 		if ( f_i )
 #pragma GCC diagnostic push
@@ -3143,8 +3339,7 @@ unsigned int RecordVal::MemoryAllocation() const
 #pragma GCC diagnostic pop
 		}
 
-	size += util::pad_size(record_val->capacity() * sizeof(ZVal));
-	size += padded_sizeof(*record_val);
+	size += util::pad_size(max_fields * (sizeof(ZVal) + 1));
 
 	return size + padded_sizeof(*this);
 	}
@@ -3835,7 +4030,7 @@ ValPtr check_and_promote(ValPtr v, const Type* t, bool is_init,
 					promoted_v = make_intrusive<DoubleVal>(v->CoerceToDouble());
 					break;
 				case TYPE_INTERVAL:
-					promoted_v = make_intrusive<IntervalVal>(v->CoerceToDouble());
+					promoted_v = val_mgr->Interval(v->CoerceToDouble());
 					break;
 				case TYPE_TIME:
 					promoted_v = make_intrusive<TimeVal>(v->CoerceToDouble());
@@ -4026,18 +4221,117 @@ ValPtr Val::MakeCount(bro_uint_t u)
 	return make_intrusive<CountVal>(u);
 	}
 
-ValManager::ValManager()
+ValPtr Val::MakeInterval(double secs)
+	{
+	return make_intrusive<IntervalVal>(secs);
+	}
+
+// Strings that analyzers produce for most connections, preallocated for
+// ValManager::InternedString(): HTTP methods, common HTTP and MIME header
+// names, which also get their upper-cased forms, the upper-cased MIME
+// types and subtypes, and DNS ECS address families.
+static constexpr const char* interned_methods[] = {
+	"GET", "POST", "HEAD", "PUT", "DELETE", "OPTIONS", "CONNECT", "TRACE", "PATCH",
+};
+
+static constexpr const char* interned_header_names[] = {
+	"Accept",
+	"Accept-Charset",
+	"Accept-Encoding",
+	"Accept-Language",
+	"Accept-Ranges",
+	"Age",
+	"Authorization",
+	"Cache-Control",
+	"Connection",
+	"Content-Disposition",
+	"Content-Encoding",
+	"Content-Language",
+	"Content-Length",
+	"Content-Location",
+	"Content-Range",
+	"Content-Transfer-Encoding",
+	"Content-Type",
+	"Cookie",
+	"Date",
+	"ETag",
+	"Expires",
+	"From",
+	"Host",
+	"If-Modified-Since",
+	"If-None-Match",
+	"Keep-Alive",
+	"Last-Modified",
+	"Location",
+	"MIME-Version",
+	"Message-ID",
+	"Origin",
+	"Pragma",
+	"Range",
+	"Received",
+	"Referer",
+	"Reply-To",
+	"Server",
+	"Set-Cookie",
+	"Subject",
+	"To",
+	"Transfer-Encoding",
+	"Upgrade",
+	"User-Agent",
+	"Vary",
+	"Via",
+	"X-Forwarded-For",
+};
+
+static constexpr const char* interned_content_types[] = {
+	"APPLICATION",
+	"AUDIO",
+	"IMAGE",
+	"MESSAGE",
+	"MULTIPART",
+	"TEXT",
+	"VIDEO",
+	"ALTERNATIVE",
+	"CSS",
+	"FORM-DATA",
+	"GIF",
+	"HTML",
+	"JAVASCRIPT",
+	"JPEG",
+	"JSON",
+	"MIXED",
+	"OCTET-STREAM",
+	"PDF",
+	"PLAIN",
+	"PNG",
+	"RELATED",
+	"RFC822",
+	"X-WWW-FORM-URLENCODED",
+	"XML",
+};
+
+static constexpr const char* interned_ecs_families[] = {"v4", "v6"};
+
+ValManager::ValManager(bro_uint_t max_count, bro_int_t arg_max_int)
 	{
 	empty_string = make_intrusive<StringVal>("");
 	b_false = Val::MakeBool(false);
 	b_true = Val::MakeBool(true);
 
-	for ( auto i = 0u; i < PREALLOCATED_COUNTS; ++i )
+	max_int = std::max(arg_max_int, PREALLOCATED_INT_LOWEST - 1);
+
+	counts.resize(max_count + 1);
+	ints.resize(max_int - PREALLOCATED_INT_LOWEST + 1);
+
+	for ( auto i = 0u; i < counts.size(); ++i )
 		counts[i] = Val::MakeCount(i);
 
-	for ( auto i = 0u; i < PREALLOCATED_INTS; ++i )
+	for ( auto i = 0u; i < ints.size(); ++i )
 		ints[i] = Val::MakeInt(PREALLOCATED_INT_LOWEST + i);
 
+	for ( auto i = 0u; i < intervals.size(); ++i )
+		intervals[i] = Val::MakeInterval(i);
+
 	for ( auto i = 0u; i < ports.size(); ++i )
 		{
 		auto& arr = ports[i];
@@ -4046,6 +4340,40 @@ ValManager::ValManager()
 		for ( auto j = 0u; j < arr.size(); ++j )
 			arr[j] = IntrusivePtr{AdoptRef{}, new PortVal(PortVal::Mask(j, port_type))};
 		}
+
+	for ( auto s : interned_methods )
+		Intern(s);
+
+	for ( auto s : interned_header_names )
+		{
+		Intern(s);
+		Intern(util::to_upper(s));
+		}
+
+	for ( auto s : interned_content_types )
+		Intern(s);
+
+	for ( auto s : interned_ecs_families )
+		Intern(s);
+	}
+
+void ValManager::Intern(const std::string& s)
+	{
+	auto v = make_intrusive<StringVal>(s);
+	interned_strings.emplace(v->ToStdStringView(), v);
+	max_interned_len = std::max(max_interned_len, s.size());
+	}
+
+StringValPtr ValManager::InternedString(std::string_view s)
+	{
+	if ( s.empty() )
+		return empty_string;
+
+	if ( s.size() <= max_interned_len )
+		if ( auto it = interned_strings.find(s); it != interned_strings.end() )
+			return it->second;
+
+	return make_intrusive<StringVal>(s.size(), s.data());
 	}
 
 const PortValPtr& ValManager::Port(uint32_t port_num, TransportProto port_type) const
@@ -4,7 +4,10 @@
 
 #include <sys/types.h> // for u_char
 #include <array>
+#include <cmath>
 #include <list>
+#include <map>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -238,6 +241,7 @@ protected:
 	static ValPtr MakeBool(bool b);
 	static ValPtr MakeInt(bro_int_t i);
 	static ValPtr MakeCount(bro_uint_t u);
+	static ValPtr MakeInterval(double secs);
 
 	explicit Val(TypePtr t) noexcept : type(std::move(t)) { }
 
@@ -268,13 +272,22 @@ protected:
 class ValManager
 	{
 public:
-	static constexpr bro_uint_t PREALLOCATED_COUNTS = 4096;
-	static constexpr bro_uint_t PREALLOCATED_INTS = 512;
+	// Defaults for how many counts and ints to preallocate.
+	static constexpr bro_uint_t PREALLOCATED_COUNTS = 65536;
+	static constexpr bro_uint_t PREALLOCATED_INTS = 4352;
 	static constexpr bro_int_t PREALLOCATED_INT_LOWEST = -255;
 	static constexpr bro_int_t PREALLOCATED_INT_HIGHEST = PREALLOCATED_INT_LOWEST +
 	                                                      PREALLOCATED_INTS - 1;
+	// Intervals of whole seconds below this are preallocated.
+	static constexpr bro_uint_t PREALLOCATED_INTERVALS = 3601;
 
-	ValManager();
+	/**
+	 * @param max_count  The largest count to preallocate, starting at 0.
+	 * @param max_int  The largest int to preallocate, starting at
+	 * PREALLOCATED_INT_LOWEST.
+	 */
+	explicit ValManager(bro_uint_t max_count = PREALLOCATED_COUNTS - 1,
+	                    bro_int_t max_int = PREALLOCATED_INT_HIGHEST);
 
 	inline const ValPtr& True() const { return b_true; }
 
@@ -284,18 +297,38 @@ public:
 
 	inline ValPtr Int(int64_t i) const
 		{
-		return i < PREALLOCATED_INT_LOWEST || i > PREALLOCATED_INT_HIGHEST
-		           ? Val::MakeInt(i)
-		           : ints[i - PREALLOCATED_INT_LOWEST];
+		return i < PREALLOCATED_INT_LOWEST || i > max_int ? Val::MakeInt(i)
+		                                                  : ints[i - PREALLOCATED_INT_LOWEST];
 		}
 
 	inline ValPtr Count(uint64_t i) const
 		{
-		return i >= PREALLOCATED_COUNTS ? Val::MakeCount(i) : counts[i];
+		return i >= counts.size() ? Val::MakeCount(i) : counts[i];
+		}
+
+	// Interval given in seconds.
+	inline ValPtr Interval(double secs) const
+		{
+		if ( secs >= 0.0 && secs < PREALLOCATED_INTERVALS && ! std::signbit(secs) )
+			{
+			auto i = static_cast<bro_uint_t>(secs);
+
+			if ( i == secs )
+				return intervals[i];
+			}
+
+		return Val::MakeInterval(secs);
 		}
 
 	inline const StringValPtr& EmptyString() const { return empty_string; }
 
+	// Returns a StringVal for a string that analyzers produce over and
+	// over, such as an HTTP method, header name or MIME type. For the
+	// fixed set of such strings that get preallocated, that's a single
+	// shared one, which callers must not modify. Any other string gets
+	// a StringVal of its own, so input can't grow the set.
+	StringValPtr InternedString(std::string_view s);
+
 	// Port number given in host order.
 	const PortValPtr& Port(uint32_t port_num, TransportProto port_type) const;
 
@@ -303,10 +336,18 @@ public:
 	const PortValPtr& Port(uint32_t port_num) const;
 
 private:
+	// Preallocates the shared StringVal for a string.
+	void Intern(const std::string& s);
+
 	std::array<std::array<PortValPtr, 65536>, NUM_PORT_SPACES> ports;
-	std::array<ValPtr, PREALLOCATED_COUNTS> counts;
-	std::array<ValPtr, PREALLOCATED_INTS> ints;
+	std::vector<ValPtr> counts;
+	std::vector<ValPtr> ints;
+	bro_int_t max_int;
+	std::array<ValPtr, PREALLOCATED_INTERVALS> intervals;
 	StringValPtr empty_string;
+	// Keyed by the bytes of the interned StringVal itself.
+	std::unordered_map<std::string_view, StringValPtr> interned_strings;
+	size_t max_interned_len = 0;
 	ValPtr b_true;
 	ValPtr b_false;
 	};
@@ -707,6 +748,10 @@ protected:
 	// to save a few bytes, as we do not need a high resolution for these
 	// anyway.
 	int expire_access_time;
+
+	// Identifies the table's expiration bucket reference to this entry's
+	// key (see TableVal::ExpireRef); kept when the entry gets replaced.
+	uint32_t expire_serial = 0;
 	};
 
 class TableValTimer final : public detail::Timer
@@ -1006,6 +1051,21 @@ protected:
 	bool ExpandCompoundAndInit(ListVal* lv, int k, ValPtr new_val);
 	bool CheckAndAssign(ValPtr index, ValPtr new_val);
 
+	// Looks up the entry for the given index, building the key on the
+	// stack if the index type allows it. Returns nullptr if there's none,
+	// or if the index doesn't match the table's index type.
+	TableEntryVal* LookupEntry(const Val& index);
+
+	// Hashes key bytes the way this table does: with the keyed hash by
+	// default, or the fast one with &fast_hash.
+	detail::hash_t KeyHash(const void* key, size_t size) const;
+
+	// Returns a key for looking up the given key of this table in tv, which
+	// is of the same type. Their key bytes match, but tv may hash them
+	// differently, in which case this rehashes the key.
+	std::unique_ptr<detail::HashKey> KeyFor(const TableVal& tv,
+	                                        std::unique_ptr<detail::HashKey> k) const;
+
 	// Calculates default value for index.  Returns nullptr if none.
 	ValPtr Default(const ValPtr& index);
 
@@ -1020,6 +1080,29 @@ protected:
 	// Calls &expire_func and returns its return interval;
 	double CallExpireFunc(ListValPtr idx);
 
+	// A reference from the expiration buckets to a table entry: the
+	// entry's hash as kept by the dictionary, and its serial. The serial
+	// tells the entry apart from others with the same hash, and from
+	// entries that got removed (and maybe added anew, with their own
+	// reference) since.
+	struct ExpireRef
+		{
+		uint32_t hash;
+		uint32_t serial;
+		};
+
+	// Files a reference under the bucket for the given time.
+	void AddExpireRef(ExpireRef ref, double due);
+
+	// Returns the entry a reference refers to, nullptr if it's gone. If
+	// k isn't null, it's set to the entry's key.
+	TableEntryVal* LookupExpireRef(const ExpireRef& ref,
+	                               std::unique_ptr<detail::HashKey>* k = nullptr) const;
+
+	// Gives each entry a new reference, filed according to its last
+	// access and expire_timeout.
+	void RebuildExpireBuckets();
+
 	// Enum for the different kinds of changes an &on_change handler can see
 	enum OnChangeType
 		{
@@ -1039,11 +1122,11 @@ protected:
 
 	TableTypePtr table_type;
 	detail::CompositeHash* table_hash;
+	bool fast_hash = false; // whether to use KeyedHash::FastHash64()
 	detail::AttributesPtr attrs;
 	detail::ExprPtr expire_time;
 	detail::ExprPtr expire_func;
 	TableValTimer* timer;
-	RobustDictIterator* expire_iterator;
 	detail::PrefixTable* subnets;
 	ValPtr def_val;
 	detail::ExprPtr change_func;
@@ -1051,6 +1134,18 @@ protected:
 	// prevent recursion of change functions
 	bool in_change_func = false;
 
+	// Entry references by the time at which the entries may expire, in
+	// buckets of table_expire_interval. DoExpire() only visits the buckets
+	// that are due. Reads and writes don't update this; an entry accessed
+	// in the meantime gets filed under a later bucket once its current one
+	// comes up. Removed entries leave their references behind until then,
+	// or until they outnumber the entries and DoExpire() rebuilds the
+	// buckets.
+	std::map<int64_t, std::vector<ExpireRef>> expire_buckets;
+	double expire_timeout = 0.0; // timeout the buckets are based on
+	uint32_t expire_serials = 0;
+	int expire_stale_refs = 0; // references to removed entries
+
 	static TableRecordDependencies parse_time_table_record_dependencies;
 	static ParseTimeTableStates parse_time_table_states;
 
@@ -1114,13 +1209,15 @@ public:
 	// The following provide efficient record field assignments.
 	void Assign(int field, bool new_val)
 		{
-		(*record_val)[field] = ZVal(bro_int_t(new_val));
+		record_val[field] = ZVal(bro_int_t(new_val));
+		MarkPresent(field);
 		AddedField(field);
 		}
 
 	void Assign(int field, int new_val)
 		{
-		(*record_val)[field] = ZVal(bro_int_t(new_val));
+		record_val[field] = ZVal(bro_int_t(new_val));
+		MarkPresent(field);
 		AddedField(field);
 		}
 
@@ -1129,18 +1226,21 @@ public:
 	// than the other.
 	void Assign(int field, uint32_t new_val)
 		{
-		(*record_val)[field] = ZVal(bro_uint_t(new_val));
+		record_val[field] = ZVal(bro_uint_t(new_val));
+		MarkPresent(field);
 		AddedField(field);
 		}
 	void Assign(int field, uint64_t new_val)
 		{
-		(*record_val)[field] = ZVal(bro_uint_t(new_val));
+		record_val[field] = ZVal(bro_uint_t(new_val));
+		MarkPresent(field);
 		AddedField(field);
 		}
 
 	void Assign(int field, double new_val)
 		{
-		(*record_val)[field] = ZVal(new_val);
+		record_val[field] = ZVal(new_val);
+		MarkPresent(field);
 		AddedField(field);
 		}
 
@@ -1154,8 +1254,9 @@ public:
 	void Assign(int field, StringVal* new_val)
 		{
 		if ( HasField(field) )
-			ZVal::DeleteManagedType(*(*record_val)[field]);
-		(*record_val)[field] = ZVal(new_val);
+			ZVal::DeleteManagedType(record_val[field]);
+		record_val[field] = ZVal(new_val);
+		MarkPresent(field);
 		AddedField(field);
 		}
 	void Assign(int field, const char* new_val) { Assign(field, new StringVal(new_val)); }
@@ -1178,7 +1279,7 @@ public:
 	 * Returns the number of fields in the record.
 	 * @return  The number of fields in the record.
 	 */
-	unsigned int NumFields() const { return record_val->size(); }
+	unsigned int NumFields() const { return num_fields; }
 
 	/**
 	 * Returns true if the given field is in the record, false if
@@ -1186,7 +1287,7 @@ public:
 	 * @param field  The field index to retrieve.
 	 * @return  Whether there's a value for the given field index.
 	 */
-	bool HasField(int field) const { return (*record_val)[field] ? true : false; }
+	bool HasField(int field) const { return FieldFlags()[field] & RecordType::FIELD_PRESENT; }
 
 	/**
 	 * Returns true if the given field is in the record, false if
@@ -1210,7 +1311,7 @@ public:
 		if ( ! HasField(field) )
 			return nullptr;
 
-		return (*record_val)[field]->ToVal(rt->GetFieldType(field));
+		return FieldVal(field).ToVal(rt->GetFieldType(field));
 		}
 
 	/**
@@ -1285,32 +1386,32 @@ public:
 		{
 		if constexpr ( std::is_same_v<T, BoolVal> || std::is_same_v<T, IntVal> ||
 		               std::is_same_v<T, EnumVal> )
-			return record_val->operator[](field)->int_val;
+			return FieldVal(field).int_val;
 		else if constexpr ( std::is_same_v<T, CountVal> )
-			return record_val->operator[](field)->uint_val;
+			return FieldVal(field).uint_val;
 		else if constexpr ( std::is_same_v<T, DoubleVal> || std::is_same_v<T, TimeVal> ||
 		                    std::is_same_v<T, IntervalVal> )
-			return record_val->operator[](field)->double_val;
+			return FieldVal(field).double_val;
 		else if constexpr ( std::is_same_v<T, PortVal> )
-			return val_mgr->Port(record_val->at(field)->uint_val);
+			return val_mgr->Port(FieldVal(field).uint_val);
 		else if constexpr ( std::is_same_v<T, StringVal> )
-			return record_val->operator[](field)->string_val->Get();
+			return FieldVal(field).string_val->Get();
 		else if constexpr ( std::is_same_v<T, AddrVal> )
-			return record_val->operator[](field)->addr_val->Get();
+			return FieldVal(field).addr_val->Get();
 		else if constexpr ( std::is_same_v<T, SubNetVal> )
-			return record_val->operator[](field)->subnet_val->Get();
+			return FieldVal(field).subnet_val->Get();
 		else if constexpr ( std::is_same_v<T, File> )
-			return *(record_val->operator[](field)->file_val);
+			return *(FieldVal(field).file_val);
 		else if constexpr ( std::is_same_v<T, Func> )
-			return *(record_val->operator[](field)->func_val);
+			return *(FieldVal(field).func_val);
 		else if constexpr ( std::is_same_v<T, PatternVal> )
-			return record_val->operator[](field)->re_val->Get();
+			return FieldVal(field).re_val->Get();
 		else if constexpr ( std::is_same_v<T, RecordVal> )
-			return record_val->operator[](field)->record_val;
+			return FieldVal(field).record_val;
 		else if constexpr ( std::is_same_v<T, VectorVal> )
-			return record_val->operator[](field)->vector_val;
+			return FieldVal(field).vector_val;
 		else if constexpr ( std::is_same_v<T, TableVal> )
-			return record_val->operator[](field)->table_val->Get();
+			return FieldVal(field).table_val->Get();
 		else
 			{
 			// It's an error to reach here, although because of
@@ -1324,11 +1425,11 @@ public:
 	T GetFieldAs(int field) const
 		{
 		if constexpr ( std::is_integral_v<T> && std::is_signed_v<T> )
-			return record_val->operator[](field)->int_val;
+			return FieldVal(field).int_val;
 		else if constexpr ( std::is_integral_v<T> && std::is_unsigned_v<T> )
-			return record_val->operator[](field)->uint_val;
+			return FieldVal(field).uint_val;
 		else if constexpr ( std::is_floating_point_v<T> )
-			return record_val->operator[](field)->double_val;
+			return FieldVal(field).double_val;
 
 		// Note: we could add other types here using type traits,
 		// such as is_same_v<T, std::string>, etc.
@@ -1401,24 +1502,38 @@ protected:
 	 */
 	void AppendField(ValPtr v, const TypePtr& t)
 		{
+		if ( num_fields == max_fields )
+			Reserve(num_fields + 1);
+
 		if ( v )
-			record_val->emplace_back(ZVal(v, t));
-		else
-			record_val->emplace_back(std::nullopt);
+			{
+			record_val[num_fields] = ZVal(v, t);
+			FieldFlags()[num_fields] = RecordType::FIELD_PRESENT;
+			}
+
+		++num_fields;
 		}
 
 	// For use by low-level ZAM instructions.  Caller assumes
 	// responsibility for memory management.  The first version
-	// allows manipulation of whether the field is present at all.
-	// The second version ensures that the optional value is present.
-	std::optional<ZVal>& RawOptField(int field) { return (*record_val)[field]; }
+	// returns the field's value, if present, for reading it.
+	// The second version marks the field as present, for writing
+	// to it.
+	std::optional<ZVal> RawOptField(int field)
+		{
+		if ( ! HasField(field) )
+			return std::nullopt;
+
+		return FieldVal(field);
+		}
 
 	ZVal& RawField(int field)
 		{
-		auto& f = RawOptField(field);
-		if ( ! f )
-			f = ZVal();
-		return *f;
+		if ( ! HasField(field) )
+			record_val[field] = ZVal();
+
+		MarkPresent(field);
+		return record_val[field];
 		}
 
 	ValPtr DoClone(CloneState* state) override;
@@ -1434,19 +1549,48 @@ private:
 	void DeleteFieldIfManaged(unsigned int field)
 		{
 		if ( HasField(field) && IsManaged(field) )
-			ZVal::DeleteManagedType(*(*record_val)[field]);
+			ZVal::DeleteManagedType(record_val[field]);
 		}
 
 	bool IsManaged(unsigned int offset) const { return is_managed[offset]; }
 
+	// The flags of the fields, which follow their values.
+	uint8_t* FieldFlags() const { return reinterpret_cast<uint8_t*>(record_val + max_fields); }
+
+	// Marks a field as having a value, which isn't lazy (anymore).
+	void MarkPresent(unsigned int field) { FieldFlags()[field] = RecordType::FIELD_PRESENT; }
+
+	// Whether the given field still needs its initial value created.
+	bool IsLazy(unsigned int field) const { return FieldFlags()[field] & RecordType::FIELD_LAZY; }
+
+	// Returns the value of a present field, creating it first if needed.
+	const ZVal& FieldVal(unsigned int field) const
+		{
+		if ( IsLazy(field) )
+			CreateLazyField(field);
+
+		return record_val[field];
+		}
+
+	void CreateLazyField(unsigned int field) const;
+
+	// Makes room for n fields, keeping the current ones. The new ones
+	// start out without a value.
+	void Reserve(unsigned int n);
+
 	// Just for template inferencing.
 	RecordVal* Get() { return this; }
 
 	// Keep this handy for quick access during low-level operations.
 	RecordTypePtr rt;
 
-	// Low-level values of each of the fields.
-	std::vector<std::optional<ZVal>>* record_val;
+	// Low-level values of each of the fields, followed by a byte of
+	// RecordType::FIELD_* flags for each of them, in one allocation
+	// with room for max_fields fields. Only the values of present,
+	// non-lazy fields are meaningful.
+	ZVal* record_val = nullptr;
+	unsigned int num_fields = 0;
+	unsigned int max_fields = 0;
 
 	// Whether a given field requires explicit memory management.
 	const std::vector<bool>& is_managed;
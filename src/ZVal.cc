@@ -1,5 +1,9 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
+#include <chrono>
+#include <vector>
+
+#include "zeek/3rdparty/doctest.h"
 #include "zeek/File.h"
 #include "zeek/Func.h"
 #include "zeek/OpaqueVal.h"
@@ -214,7 +218,7 @@ ValPtr ZVal::ToVal(const TypePtr& t) const
 			return make_intrusive<DoubleVal>(double_val);
 
 		case TYPE_INTERVAL:
-			return make_intrusive<IntervalVal>(double_val, Seconds);
+			return val_mgr->Interval(double_val);
 
 		case TYPE_TIME:
 			return make_intrusive<TimeVal>(double_val);
@@ -315,3 +319,109 @@ bool ZVal::IsManagedType(const TypePtr& t)
 			return false;
 		}
 	}
+
+TEST_SUITE_BEGIN("ZVal");
+
+TEST_CASE("preallocated vals")
+	{
+	auto prev_val_mgr = val_mgr;
+	val_mgr = new ValManager(100, 20);
+
+	const auto& count_t = base_type(TYPE_COUNT);
+	const auto& int_t = base_type(TYPE_INT);
+	const auto& interval_t = base_type(TYPE_INTERVAL);
+
+	auto shared = [](const ZVal& z, const TypePtr& t)
+		{
+		return z.ToVal(t).get() == z.ToVal(t).get();
+		};
+
+	CHECK(shared(ZVal(bro_uint_t(0)), count_t));
+	CHECK(shared(ZVal(bro_uint_t(100)), count_t));
+	CHECK_FALSE(shared(ZVal(bro_uint_t(101)), count_t));
+	CHECK_EQ(ZVal(bro_uint_t(101)).ToVal(count_t)->AsCount(), 101);
+
+	CHECK(shared(ZVal(bro_int_t(ValManager::PREALLOCATED_INT_LOWEST)), int_t));
+	CHECK(shared(ZVal(bro_int_t(20)), int_t));
+	CHECK_FALSE(shared(ZVal(bro_int_t(21)), int_t));
+	CHECK_FALSE(shared(ZVal(bro_int_t(ValManager::PREALLOCATED_INT_LOWEST - 1)), int_t));
+	CHECK_EQ(ZVal(bro_int_t(-1000)).ToVal(int_t)->AsInt(), -1000);
+
+	CHECK(shared(ZVal(0.0), interval_t));
+	CHECK(shared(ZVal(3600.0), interval_t));
+	CHECK_FALSE(shared(ZVal(3601.0), interval_t));
+	CHECK_FALSE(shared(ZVal(0.5), interval_t));
+	CHECK_FALSE(shared(ZVal(-1.0), interval_t));
+	CHECK_EQ(ZVal(60.0).ToVal(interval_t)->AsInterval(), 60.0);
+	CHECK_EQ(ZVal(0.5).ToVal(interval_t)->AsInterval(), 0.5);
+
+	delete val_mgr;
+	val_mgr = new ValManager(0, ValManager::PREALLOCATED_INT_LOWEST - 1);
+	CHECK(shared(ZVal(bro_uint_t(0)), count_t));
+	CHECK_FALSE(shared(ZVal(bro_uint_t(1)), count_t));
+	CHECK_FALSE(shared(ZVal(bro_int_t(ValManager::PREALLOCATED_INT_LOWEST)), int_t));
+
+	delete val_mgr;
+	val_mgr = prev_val_mgr;
+	}
+
+TEST_CASE("val allocation benchmark" * doctest::skip())
+	{
+	// Counts how many of the Vals that scripts get for typical values are
+	// allocated anew, with the caches sized as they used to be and as
+	// they are now. Run with "zeek --test -tc='val allocation benchmark' -ns".
+	auto prev_val_mgr = val_mgr;
+	const int rounds = 1000000;
+
+	std::vector<std::pair<const char*, TypePtr>> types = {{"count", base_type(TYPE_COUNT)},
+	                                                      {"int", base_type(TYPE_INT)},
+	                                                      {"interval", base_type(TYPE_INTERVAL)}};
+
+	// Something like packet and payload sizes, byte counts, TTLs, small
+	// deltas and timeouts.
+	auto value = [](const TypePtr& t, int i) -> ZVal
+		{
+		switch ( t->Tag() )
+			{
+			case TYPE_COUNT:
+				return i % 2 ? bro_uint_t(i % 1500) : bro_uint_t(i % 65536);
+			case TYPE_INT:
+				return i % 2 ? bro_int_t(i % 256 - 128) : bro_int_t(i % 8192 - 4096);
+			default:
+				return i % 4 ? double(i % 3600) : double(i % 3600) + 0.5;
+			}
+		};
+
+	for ( auto [max_count, max_int] : {std::pair<bro_uint_t, bro_int_t>{4095, 256},
+	                                   {ValManager::PREALLOCATED_COUNTS - 1,
+	                                    ValManager::PREALLOCATED_INT_HIGHEST}} )
+		{
+		val_mgr = new ValManager(max_count, max_int);
+
+		for ( const auto& [name, t] : types )
+			{
+			int allocated = 0;
+			auto start = std::chrono::steady_clock::now();
+
+			for ( int i = 0; i < rounds; ++i )
+				{
+				auto v = value(t, i).ToVal(t);
+
+				// The cached ones are also referenced by the ValManager.
+				if ( v->RefCnt() == 1 )
+					++allocated;
+				}
+
+			std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+			MESSAGE(name << ", max count " << max_count << ", max int " << max_int << ": "
+			             << allocated << " of " << rounds << " allocated, "
+			             << secs.count() * 1e9 / rounds << " ns per conversion");
+			}
+
+		delete val_mgr;
+		}
+
+	val_mgr = prev_val_mgr;
+	}
+
+TEST_SUITE_END();
@@ -19,6 +19,55 @@ Args val_list_to_args(const ValPList& vl)
 	return rval;
 	}
 
+namespace detail
+	{
+
+// Event queueing creates and drops an argument list for every event. We
+// keep a number of dropped lists around for reuse, as long as they're not
+// unusually large.
+static constexpr size_t MAX_SPARE_ARGS = 1024;
+static constexpr size_t MAX_SPARE_ARGS_CAPACITY = 16;
+
+static std::vector<Args>& spare_args()
+	{
+	// Never deleted, so that events dropped during shutdown can still
+	// recycle their arguments.
+	static auto spares = new std::vector<Args>;
+	return *spares;
+	}
+
+Args new_args(size_t n)
+	{
+	auto& spares = spare_args();
+	Args rval;
+
+	if ( ! spares.empty() )
+		{
+		rval = std::move(spares.back());
+		spares.pop_back();
+		}
+
+	rval.reserve(n);
+	return rval;
+	}
+
+void recycle_args(Args&& args)
+	{
+	auto& spares = spare_args();
+
+	if ( spares.size() >= MAX_SPARE_ARGS || args.capacity() > MAX_SPARE_ARGS_CAPACITY ||
+	     args.capacity() == 0 )
+		{
+		Args().swap(args);
+		return;
+		}
+
+	args.clear();
+	spares.emplace_back(std::move(args));
+	}
+
+	} // namespace detail
+
 VectorValPtr MakeCallArgumentVector(const Args& vals, const RecordTypePtr& types)
 	{
 	static auto call_argument_vector = id::find_type<VectorType>("call_argument_vector");
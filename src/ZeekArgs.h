@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "zeek/ZeekList.h"
@@ -39,4 +40,32 @@ Args val_list_to_args(const ValPList& vl);
  */
 VectorValPtr MakeCallArgumentVector(const Args& vals, const RecordTypePtr& types);
 
+namespace detail
+	{
+
+/**
+ * Returns an empty argument list with room for at least *n* arguments,
+ * reusing the storage of one passed to recycle_args() if possible.
+ */
+Args new_args(size_t n);
+
+/**
+ * Takes back an argument list that's no longer needed, releasing its
+ * values, for reuse by new_args().
+ */
+void recycle_args(Args&& args);
+
+/**
+ * Builds an argument list from the given values, the way event queueing
+ * does for its variadic versions.
+ */
+template <class... T> Args make_args(T&&... vals)
+	{
+	auto args = new_args(sizeof...(vals));
+	(args.emplace_back(std::forward<T>(vals)), ...);
+	return args;
+	}
+
+	} // namespace detail
+
 	} // namespace zeek
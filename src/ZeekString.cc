@@ -6,7 +6,9 @@
 
 #include <ctype.h>
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <sstream> // Needed for unit testing
 
 #include "zeek/3rdparty/doctest.h"
@@ -72,10 +74,13 @@ String::String()
 
 void String::Reset()
 	{
-	if ( use_free_to_delete )
-		free(b);
-	else
-		delete[] b;
+	if ( ! IsInline() )
+		{
+		if ( use_free_to_delete )
+			free(b);
+		else
+			delete[] b;
+		}
 
 	b = nullptr;
 	n = 0;
@@ -87,7 +92,7 @@ const String& String::operator=(const String& bs)
 	{
 	Reset();
 	n = bs.n;
-	b = new u_char[n + 1];
+	b = Allocate(n + 1);
 
 	memcpy(b, bs.b, n);
 	b[n] = '\0';
@@ -137,7 +142,7 @@ void String::Set(const u_char* str, int len, bool add_NUL)
 	Reset();
 
 	n = len;
-	b = new u_char[add_NUL ? n + 1 : n];
+	b = Allocate(add_NUL ? n + 1 : n);
 	memcpy(b, str, n);
 	final_NUL = add_NUL;
 
@@ -154,7 +159,7 @@ void String::Set(const char* str)
 	if ( str )
 		{
 		n = strlen(str);
-		b = new u_char[n + 1];
+		b = Allocate(n + 1);
 		memcpy(b, str, n + 1);
 		final_NUL = true;
 		use_free_to_delete = false;
@@ -166,7 +171,7 @@ void String::Set(const std::string& str)
 	Reset();
 
 	n = str.size();
-	b = new u_char[n + 1];
+	b = Allocate(n + 1);
 	memcpy(b, str.c_str(), n + 1);
 	final_NUL = true;
 	use_free_to_delete = false;
@@ -306,6 +311,9 @@ void String::ToUpper()
 
 unsigned int String::MemoryAllocation() const
 	{
+	if ( IsInline() )
+		return padded_sizeof(*this);
+
 	return padded_sizeof(*this) + util::pad_size(n + final_NUL);
 	}
 
@@ -748,4 +756,94 @@ TEST_CASE("misc")
 		delete entry;
 	}
 
+TEST_CASE("inline storage")
+	{
+	auto is_inline = [](const zeek::String& s)
+		{
+		auto* begin = reinterpret_cast<const u_char*>(&s);
+		return s.Bytes() >= begin && s.Bytes() < begin + sizeof(s);
+		};
+
+	zeek::String s1{"GET"};
+	CHECK(is_inline(s1));
+	CHECK_EQ(s1, "GET");
+	CHECK_EQ(std::string(s1.CheckString()), "GET");
+
+	zeek::String s2{"application/x-www-form-urlencoded"};
+	CHECK_FALSE(is_inline(s2));
+	CHECK_EQ(s2, "application/x-www-form-urlencoded");
+
+	// Copies get their own bytes, whether inline or not.
+	zeek::String s3{s1};
+	s3.ToUpper();
+	s3.Bytes()[0] = 'P';
+	CHECK_EQ(s3, "PET");
+	CHECK_EQ(s1, "GET");
+
+	s3 = s2;
+	CHECK_EQ(s3, s2);
+	CHECK_NE(s3.Bytes(), s2.Bytes());
+
+	s2.Set("POST");
+	CHECK(is_inline(s2));
+	CHECK_EQ(s2, "POST");
+	s1.Set(std::string(zeek::String::INLINE_SIZE, 'x'));
+	CHECK_EQ(s1.Len(), zeek::String::INLINE_SIZE);
+	CHECK_EQ(s1, std::string(zeek::String::INLINE_SIZE, 'x'));
+
+	auto* ss = s3.GetSubstring(0, 11);
+	CHECK_EQ(*ss, "application");
+	delete ss;
+	}
+
+TEST_CASE("interned strings")
+	{
+	auto vm = std::make_unique<zeek::ValManager>(0, 0);
+
+	// Preallocated strings are shared.
+	CHECK_EQ(vm->InternedString("GET"), vm->InternedString("GET"));
+	CHECK_EQ(vm->InternedString("User-Agent"), vm->InternedString("User-Agent"));
+	CHECK_EQ(vm->InternedString("USER-AGENT"), vm->InternedString("USER-AGENT"));
+	CHECK_EQ(vm->InternedString("OCTET-STREAM")->ToStdString(), "OCTET-STREAM");
+
+	// Anything else, like a header name an attacker picked, isn't kept.
+	auto x = vm->InternedString("X-Made-Up");
+	CHECK_NE(x, vm->InternedString("X-Made-Up"));
+	CHECK_EQ(x->RefCnt(), 1);
+	CHECK_EQ(x->ToStdString(), "X-Made-Up");
+	}
+
+TEST_CASE("string benchmark" * doctest::skip())
+	{
+	// Compares creating short strings, which are stored inline, with
+	// longer ones, and new StringVals with interned ones. Run with
+	// "zeek --test -tc='string benchmark' -ns".
+	const int rounds = 1000000;
+	const std::vector<std::string> words = {"GET",  "POST",       "HOST",
+	                                        "AAAA", "USER-AGENT", "application/octet-stream"};
+	auto vm = std::make_unique<zeek::ValManager>();
+
+	auto time = [&](const char* what, const std::string& w, auto f)
+		{
+		size_t sum = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < rounds; ++i )
+			sum += f(w);
+
+		std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+		MESSAGE(what << ", " << w.size() << " bytes: " << secs.count() * 1e9 / rounds
+		             << " ns per string (" << sum % 10 << ")");
+		};
+
+	for ( const auto& w : words )
+		{
+		time("String", w, [](const std::string& w) { return zeek::String(w).Bytes()[0]; });
+		time("StringVal", w,
+		     [](const std::string& w) { return zeek::make_intrusive<zeek::StringVal>(w)->Len(); });
+		time("interned StringVal", w,
+		     [&](const std::string& w) { return vm->InternedString(w)->Len(); });
+		}
+	}
+
 TEST_SUITE_END();
@@ -41,6 +41,11 @@ public:
 	using IdxVecIt = IdxVec::iterator;
 	using IdxVecCIt = IdxVec::const_iterator;
 
+	// Copies of strings of up to this many bytes, including a final NUL,
+	// are kept inside the String itself, rather than in a buffer of their
+	// own. Byte vectors that a String adopts are used as they are.
+	static constexpr int INLINE_SIZE = 16;
+
 	// Constructors creating internal copies of the data passed in.
 	String(const u_char* str, int arg_n, bool add_NUL);
 	explicit String(const char* str);
@@ -162,10 +167,17 @@ public:
 protected:
 	void Reset();
 
+	// Returns storage for the given number of bytes: the inline buffer
+	// if they fit, a new one otherwise.
+	byte_vec Allocate(int size) { return size <= INLINE_SIZE ? inline_bytes : new u_char[size]; }
+
+	bool IsInline() const { return b == inline_bytes; }
+
 	byte_vec b;
 	int n;
 	bool final_NUL; // whether we have added a final NUL
 	bool use_free_to_delete; // free() vs. operator delete
+	u_char inline_bytes[INLINE_SIZE];
 	};
 
 // A comparison class that sorts pointers to String's according to
@@ -5,7 +5,9 @@
 #include <binpac.h>
 #include <algorithm>
 
+#include "zeek/AnalyzerStats.h"
 #include "zeek/Event.h"
+#include "zeek/NetVar.h"
 #include "zeek/ZeekString.h"
 #include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/pia/PIA.h"
@@ -75,6 +77,17 @@ const char* Analyzer::GetAnalyzerName() const
 	return analyzer_mgr->GetComponentName(tag).c_str();
 	}
 
+zeek::detail::AnalyzerStats* Analyzer::Stats()
+	{
+	if ( ! zeek::detail::analyzer_profiling )
+		return nullptr;
+
+	if ( ! stats )
+		stats = zeek::detail::AnalyzerStats::Lookup("protocol", GetAnalyzerName());
+
+	return stats;
+	}
+
 void Analyzer::SetAnalyzerTag(const Tag& arg_tag)
 	{
 	assert(! tag || tag == arg_tag);
@@ -222,6 +235,7 @@ void Analyzer::NextPacket(int len, const u_char* data, bool is_orig, uint64_t se
 		{
 		try
 			{
+			zeek::detail::AnalyzerStatsScope profile(Stats(), len);
 			DeliverPacket(len, data, is_orig, seq, ip, caplen);
 			}
 		catch ( binpac::Exception const& e )
@@ -245,6 +259,7 @@ void Analyzer::NextStream(int len, const u_char* data, bool is_orig)
 		{
 		try
 			{
+			zeek::detail::AnalyzerStatsScope profile(Stats(), len);
 			DeliverStream(len, data, is_orig);
 			}
 		catch ( binpac::Exception const& e )
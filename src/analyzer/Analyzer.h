@@ -26,6 +26,7 @@ using RecordValPtr = zeek::IntrusivePtr<RecordVal>;
 namespace detail
 	{
 class Rule;
+class AnalyzerStats;
 	}
 namespace packet_analysis::IP
 	{
@@ -594,7 +595,25 @@ public:
 	std::enable_if_t<std::is_convertible_v<std::tuple_element_t<0, std::tuple<Args...>>, ValPtr>>
 	EnqueueConnEvent(EventHandlerPtr h, Args&&... args)
 		{
-		return EnqueueConnEvent(h, zeek::Args{std::forward<Args>(args)...});
+		return EnqueueConnEvent(h, zeek::detail::make_args(std::forward<Args>(args)...));
+		}
+
+	/**
+	 * A version of EnqueueConnEvent() that builds the arguments only if
+	 * the event will actually get raised, i.e., if it has a handler and
+	 * hasn't been disabled. Use this where computing the arguments is
+	 * expensive, instead of checking the handler separately.
+	 *
+	 * @param h  the event to raise.
+	 * @param build_args  a callable returning the event's zeek::Args,
+	 * such as a lambda returning zeek::detail::make_args(...).
+	 */
+	template <class F>
+	std::enable_if_t<std::is_invocable_r_v<zeek::Args, F>>
+	EnqueueConnEvent(EventHandlerPtr h, F&& build_args)
+		{
+		if ( h )
+			EnqueueConnEvent(h, std::forward<F>(build_args)());
 		}
 
 	/**
@@ -713,6 +732,10 @@ private:
 	// Helper for the ctors.
 	void CtorInit(const Tag& tag, Connection* conn);
 
+	// Returns the analyzer_profiling metrics for this analyzer, or null
+	// if profiling is off.
+	zeek::detail::AnalyzerStats* Stats();
+
 	Tag tag;
 	ID id;
 
@@ -736,6 +759,8 @@ private:
 	bool finished;
 	bool removing;
 
+	zeek::detail::AnalyzerStats* stats = nullptr;
+
 	static ID id_counter;
 	};
 
@@ -13,10 +13,24 @@
 #include "zeek/packet_analysis/protocol/ip/IPBasedAnalyzer.h"
 #include "zeek/packet_analysis/protocol/ip/SessionAdapter.h"
 #include "zeek/plugin/Manager.h"
+#include "zeek/telemetry/Manager.h"
 
 namespace zeek::analyzer
 	{
 
+namespace
+	{
+
+telemetry::IntGauge& scheduled_analyzers_gauge()
+	{
+	static auto gauge = telemetry_mgr->GaugeSingleton(
+		"zeek", "analyzer-scheduled-pending",
+		"Analyzers scheduled for expected connections that have not expired yet");
+	return gauge;
+	}
+
+	} // namespace
+
 Manager::ConnIndex::ConnIndex(const IPAddr& _orig, const IPAddr& _resp, uint16_t _resp_p,
                               uint16_t _proto)
 	{
@@ -56,6 +70,30 @@ bool Manager::ConnIndex::operator<(const ConnIndex& other) const
 	return false;
 	}
 
+bool Manager::ConnIndex::operator==(const ConnIndex& other) const
+	{
+	return resp_p == other.resp_p && proto == other.proto && resp == other.resp &&
+	       orig == other.orig;
+	}
+
+std::size_t Manager::ConnIndex::Hash() const
+	{
+	struct
+		{
+		in6_addr orig;
+		in6_addr resp;
+		uint16_t resp_p;
+		uint16_t proto;
+		} key;
+
+	orig.CopyIPv6(&key.orig);
+	resp.CopyIPv6(&key.resp);
+	key.resp_p = resp_p;
+	key.proto = proto;
+
+	return zeek::detail::HashKey::HashBytes(&key, sizeof(key));
+	}
+
 Manager::Manager() : plugin::ComponentManager<analyzer::Tag, analyzer::Component>("Analyzer", "Tag")
 	{
 	}
@@ -344,28 +382,34 @@ void Manager::ExpireScheduledAnalyzers()
 
 		conns_by_timeout.pop();
 
-		std::pair<conns_map::iterator, conns_map::iterator> all = conns.equal_range(a->conn);
+		DBG_LOG(DBG_ANALYZER, "Expiring expected analyzer %s for connection %s",
+		        analyzer_mgr->GetComponentName(a->analyzer).c_str(),
+		        fmt_conn_id(a->conn.orig, 0, a->conn.resp, a->conn.resp_p));
 
-		bool found = false;
+		RemoveScheduledAnalyzer(a);
+		delete a;
+		}
+	}
 
-		for ( conns_map::iterator i = all.first; i != all.second; i++ )
-			{
-			if ( i->second != a )
-				continue;
+void Manager::RemoveScheduledAnalyzer(ScheduledAnalyzer* a)
+	{
+	auto all = conns.equal_range(a->conn);
 
-			conns.erase(i);
+	for ( auto i = all.first; i != all.second; i++ )
+		{
+		if ( i->second != a )
+			continue;
 
-			DBG_LOG(DBG_ANALYZER, "Expiring expected analyzer %s for connection %s",
-			        analyzer_mgr->GetComponentName(a->analyzer).c_str(),
-			        fmt_conn_id(a->conn.orig, 0, a->conn.resp, a->conn.resp_p));
+		conns.erase(i);
 
-			delete a;
-			found = true;
-			break;
-			}
+		if ( a->conn.IsWildcard() )
+			--num_wildcard_conns;
 
-		assert(found);
+		scheduled_analyzers_gauge().Dec();
+		return;
 		}
+
+	assert(false);
 	}
 
 void Manager::ScheduleAnalyzer(const IPAddr& orig, const IPAddr& resp, uint16_t resp_p,
@@ -389,6 +433,11 @@ void Manager::ScheduleAnalyzer(const IPAddr& orig, const IPAddr& resp, uint16_t
 
 	conns.insert(std::make_pair(a->conn, a));
 	conns_by_timeout.push(a);
+
+	if ( a->conn.IsWildcard() )
+		++num_wildcard_conns;
+
+	scheduled_analyzers_gauge().Inc();
 	}
 
 void Manager::ScheduleAnalyzer(const IPAddr& orig, const IPAddr& resp, uint16_t resp_p,
@@ -410,15 +459,22 @@ void Manager::ScheduleAnalyzer(const IPAddr& orig, const IPAddr& resp, PortVal*
 
 Manager::tag_set Manager::GetScheduled(const Connection* conn)
 	{
+	tag_set result;
+
+	// This runs for every new connection, while expectations are rare.
+	if ( conns.empty() )
+		return result;
+
 	ConnIndex c(conn->OrigAddr(), conn->RespAddr(), ntohs(conn->RespPort()), conn->ConnTransport());
 
 	std::pair<conns_map::iterator, conns_map::iterator> all = conns.equal_range(c);
 
-	tag_set result;
-
 	for ( conns_map::iterator i = all.first; i != all.second; i++ )
 		result.insert(i->second->analyzer);
 
+	if ( ! num_wildcard_conns )
+		return result;
+
 	// Try wildcard for originator.
 	c.orig = IPAddr::v6_unspecified;
 	all = conns.equal_range(c);
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <queue>
+#include <unordered_map>
 #include <vector>
 
 #include "zeek/Dict.h"
@@ -359,6 +360,17 @@ private:
 		ConnIndex();
 
 		bool operator<(const ConnIndex& other) const;
+		bool operator==(const ConnIndex& other) const;
+
+		std::size_t Hash() const;
+
+		// An originator of IPAddr::v6_unspecified matches any originator.
+		bool IsWildcard() const { return orig == IPAddr::v6_unspecified; }
+		};
+
+	struct ConnIndexHash
+		{
+		std::size_t operator()(const ConnIndex& c) const { return c.Hash(); }
 		};
 
 	// Information associated with a scheduled connection.
@@ -378,15 +390,18 @@ private:
 		};
 
 	using protocol_analyzers = std::set<std::tuple<Tag, TransportProto, uint32_t>>;
-	using conns_map = std::multimap<ConnIndex, ScheduledAnalyzer*>;
+	using conns_map = std::unordered_multimap<ConnIndex, ScheduledAnalyzer*, ConnIndexHash>;
 	using conns_queue = std::priority_queue<ScheduledAnalyzer*, std::vector<ScheduledAnalyzer*>,
 	                                        ScheduledAnalyzer::Comparator>;
 
 	bool initialized = false;
 	protocol_analyzers pending_analyzers_for_ports;
 
+	void RemoveScheduledAnalyzer(ScheduledAnalyzer* a);
+
 	conns_map conns;
 	conns_queue conns_by_timeout;
+	size_t num_wildcard_conns = 0;
 	std::vector<uint16_t> vxlan_ports;
 	};
 
@@ -88,7 +88,7 @@ void ConnSize_Analyzer::CheckThresholds(bool is_orig)
 		     conn_duration_threshold_crossed )
 			{
 			EnqueueConnEvent(conn_duration_threshold_crossed, ConnVal(),
-			                 make_intrusive<IntervalVal>(duration_thresh), val_mgr->Bool(is_orig));
+			                 val_mgr->Interval(duration_thresh), val_mgr->Bool(is_orig));
 			duration_thresh = 0;
 			}
 		}
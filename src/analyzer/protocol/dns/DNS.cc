@@ -744,7 +744,7 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 						break;
 						}
 
-					opt.ecs_family = make_intrusive<StringVal>("v4");
+					opt.ecs_family = val_mgr->InternedString("v4");
 					uint32_t addr = 0;
 					uint16_t shift_factor = 3;
 					int bits_left = opt.ecs_src_pfx_len;
@@ -780,7 +780,7 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 						break;
 						}
 
-					opt.ecs_family = make_intrusive<StringVal>("v6");
+					opt.ecs_family = val_mgr->InternedString("v6");
 					uint32_t addr[4] = {0};
 					uint16_t shift_factor = 15;
 					int bits_left = opt.ecs_src_pfx_len;
@@ -809,8 +809,13 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 					break;
 					}
 
-				analyzer->EnqueueConnEvent(dns_EDNS_ecs, analyzer->ConnVal(), msg->BuildHdrVal(),
-				                           msg->BuildEDNS_ECS_Val(&opt));
+				auto build_args = [&]()
+				{
+					return zeek::detail::make_args(analyzer->ConnVal(), msg->BuildHdrVal(),
+					                               msg->BuildEDNS_ECS_Val(&opt));
+				};
+
+				analyzer->EnqueueConnEvent(dns_EDNS_ecs, build_args);
 				data += option_len;
 				break;
 				} // END EDNS ECS
@@ -838,9 +843,14 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 						analyzer->Weird("EDNS_TCP_Keepalive_In_UDP");
 						}
 
-					analyzer->EnqueueConnEvent(dns_EDNS_tcp_keepalive, analyzer->ConnVal(),
-					                           msg->BuildHdrVal(),
-					                           msg->BuildEDNS_TCP_KA_Val(&edns_tcp_keepalive));
+					auto build_args = [&]()
+					{
+						return zeek::detail::make_args(
+							analyzer->ConnVal(), msg->BuildHdrVal(),
+							msg->BuildEDNS_TCP_KA_Val(&edns_tcp_keepalive));
+					};
+
+					analyzer->EnqueueConnEvent(dns_EDNS_tcp_keepalive, build_args);
 					}
 				else
 					{
@@ -865,6 +875,13 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 					break;
 					}
 
+				if ( ! dns_EDNS_cookie )
+					{
+					// Don't bother copying out the cookies.
+					data += option_len;
+					break;
+					}
+
 				int client_cookie_len = 8;
 				int server_cookie_len = option_len - client_cookie_len;
 
@@ -1724,12 +1741,6 @@ bool DNS_Interpreter::ParseRR_SVCB(detail::DNS_MsgInfo* msg, const u_char*& data
 		name_end = target_name + 1;
 		}
 
-	SVCB_DATA svcb_data = {
-		.svc_priority = svc_priority,
-		.target_name = make_intrusive<StringVal>(
-			new String(target_name, name_end - target_name, true)),
-	};
-
 	// TODO: parse svcparams
 	// we consume all the remaining raw data (svc params) but do nothing.
 	// this should be removed if the svc param parser is ready
@@ -1740,15 +1751,25 @@ bool DNS_Interpreter::ParseRR_SVCB(detail::DNS_MsgInfo* msg, const u_char*& data
 		data += (rdlength - parsed_bytes);
 		}
 
+	auto build_args = [&]()
+	{
+		SVCB_DATA svcb_data = {
+			.svc_priority = svc_priority,
+			.target_name = make_intrusive<StringVal>(
+				new String(target_name, name_end - target_name, true)),
+		};
+
+		return zeek::detail::make_args(analyzer->ConnVal(), msg->BuildHdrVal(),
+		                               msg->BuildAnswerVal(), msg->BuildSVCB_Val(svcb_data));
+	};
+
 	switch ( svcb_type )
 		{
 		case detail::TYPE_SVCB:
-			analyzer->EnqueueConnEvent(dns_SVCB, analyzer->ConnVal(), msg->BuildHdrVal(),
-			                           msg->BuildAnswerVal(), msg->BuildSVCB_Val(svcb_data));
+			analyzer->EnqueueConnEvent(dns_SVCB, build_args);
 			break;
 		case detail::TYPE_HTTPS:
-			analyzer->EnqueueConnEvent(dns_HTTPS, analyzer->ConnVal(), msg->BuildHdrVal(),
-			                           msg->BuildAnswerVal(), msg->BuildSVCB_Val(svcb_data));
+			analyzer->EnqueueConnEvent(dns_HTTPS, build_args);
 			break;
 		default:
 			break; // unreachable. for suppressing compiler warnings.
@@ -1226,7 +1226,7 @@ int HTTP_Analyzer::HTTP_RequestLine(const char* line, const char* end_of_line)
 		return -1;
 		}
 
-	request_method = make_intrusive<StringVal>(end_of_method - line, line);
+	request_method = val_mgr->InternedString({line, static_cast<size_t>(end_of_method - line)});
 
 	Conn()->Match(zeek::detail::Rule::HTTP_REQUEST,
 	              (const u_char*)unescaped_URI->AsString()->Bytes(),
@@ -1593,11 +1593,9 @@ void HTTP_Analyzer::HTTP_Header(bool is_orig, analyzer::mime::MIME_Header* h)
 		if ( DEBUG_http )
 			DEBUG_MSG("%.6f http_header\n", run_state::network_time);
 
-		auto upper_hn = analyzer::mime::to_string_val(h->get_name());
-		upper_hn->ToUpper();
-
 		EnqueueConnEvent(http_header, ConnVal(), val_mgr->Bool(is_orig),
-		                 analyzer::mime::to_string_val(h->get_name()), std::move(upper_hn),
+		                 analyzer::mime::to_interned_string_val(h->get_name()),
+		                 analyzer::mime::to_upper_interned_string_val(h->get_name()),
 		                 analyzer::mime::to_string_val(h->get_value()));
 		}
 	}
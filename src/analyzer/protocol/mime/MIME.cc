@@ -123,6 +123,16 @@ StringValPtr to_string_val(const data_chunk_t buf)
 	return to_string_val(buf.length, buf.data);
 	}
 
+StringValPtr to_interned_string_val(const data_chunk_t buf)
+	{
+	return val_mgr->InternedString({buf.data, static_cast<size_t>(buf.length)});
+	}
+
+StringValPtr to_upper_interned_string_val(const data_chunk_t buf)
+	{
+	return val_mgr->InternedString(util::to_upper(std::string(buf.data, buf.length)));
+	}
+
 static data_chunk_t get_data_chunk(String* s)
 	{
 	data_chunk_t b;
@@ -546,8 +556,8 @@ void MIME_Entity::init()
 
 	need_to_parse_parameters = 0;
 
-	content_type_str = make_intrusive<StringVal>("TEXT");
-	content_subtype_str = make_intrusive<StringVal>("PLAIN");
+	content_type_str = val_mgr->InternedString("TEXT");
+	content_subtype_str = val_mgr->InternedString("PLAIN");
 
 	content_encoding_str = nullptr;
 	multipart_boundary = nullptr;
@@ -798,10 +808,8 @@ bool MIME_Entity::ParseContentTypeField(MIME_Header* h)
 	data += offset;
 	len -= offset;
 
-	content_type_str = make_intrusive<StringVal>(ty.length, ty.data);
-	content_type_str->ToUpper();
-	content_subtype_str = make_intrusive<StringVal>(subty.length, subty.data);
-	content_subtype_str->ToUpper();
+	content_type_str = to_upper_interned_string_val(ty);
+	content_subtype_str = to_upper_interned_string_val(subty);
 
 	ParseContentType(ty, subty);
 
@@ -1290,10 +1298,8 @@ RecordValPtr MIME_Message::ToHeaderVal(MIME_Header* h)
 	{
 	static auto mime_header_rec = id::find_type<RecordType>("mime_header_rec");
 	auto header_record = make_intrusive<RecordVal>(mime_header_rec);
-	header_record->Assign(0, to_string_val(h->get_name()));
-	auto upper_hn = to_string_val(h->get_name());
-	upper_hn->ToUpper();
-	header_record->Assign(1, std::move(upper_hn));
+	header_record->Assign(0, to_interned_string_val(h->get_name()));
+	header_record->Assign(1, to_upper_interned_string_val(h->get_name()));
 	header_record->Assign(2, to_string_val(h->get_value()));
 	return header_record;
 	}
@@ -281,6 +281,10 @@ extern bool is_null_data_chunk(data_chunk_t b);
 extern StringValPtr to_string_val(int length, const char* data);
 extern StringValPtr to_string_val(const char* data, const char* end_of_data);
 extern StringValPtr to_string_val(const data_chunk_t buf);
+// Like to_string_val(), for strings seen over and over, such as header
+// names. The result may be shared, so callers must not modify it.
+extern StringValPtr to_interned_string_val(const data_chunk_t buf);
+extern StringValPtr to_upper_interned_string_val(const data_chunk_t buf);
 extern int fputs(data_chunk_t b, FILE* fp);
 extern bool istrequal(data_chunk_t s, const char* t);
 extern bool is_lws(char ch);
@@ -9,10 +9,57 @@
 #include "zeek/RunState.h"
 #include "zeek/analyzer/protocol/tcp/TCP_Flags.h"
 #include "zeek/analyzer/protocol/tcp/TCP_Reassembler.h"
+#include "zeek/telemetry/Manager.h"
 
 namespace zeek::analyzer::pia
 	{
 
+namespace
+	{
+
+// Payload bytes currently buffered by all PIAs.  Shared blocks are
+// accounted for only once.
+int64_t total_buffered_bytes = 0;
+
+telemetry::IntGauge& buffered_bytes_gauge()
+	{
+	static auto gauge = telemetry_mgr->GaugeSingleton(
+		"zeek", "pia-buffered-bytes", "Payload bytes buffered for dynamic protocol detection",
+		"bytes");
+	return gauge;
+	}
+
+telemetry::IntCounter& global_limit_counter()
+	{
+	static auto counter = telemetry_mgr->CounterSingleton(
+		"zeek", "pia-global-limit-hits",
+		"DPD buffers stopped early because dpd_max_total_buffer_size was reached");
+	return counter;
+	}
+
+std::shared_ptr<const u_char> make_payload(int len, const u_char* data)
+	{
+	u_char* tmp = new u_char[len];
+	memcpy(tmp, data, len);
+
+	total_buffered_bytes += len;
+	buffered_bytes_gauge().Inc(len);
+
+	return {tmp, [len](const u_char* p)
+	        {
+			total_buffered_bytes -= len;
+
+			// Connections may outlive the telemetry manager during
+			// shutdown.
+			if ( telemetry_mgr )
+				buffered_bytes_gauge().Dec(len);
+
+			delete[] p;
+			}};
+	}
+
+	} // namespace
+
 PIA::PIA(analyzer::Analyzer* arg_as_analyzer)
 	: state(INIT), as_analyzer(arg_as_analyzer), conn(), current_packet()
 	{
@@ -20,7 +67,7 @@ PIA::PIA(analyzer::Analyzer* arg_as_analyzer)
 
 PIA::~PIA()
 	{
-	ClearBuffer(&pkt_buffer);
+	ClearBuffer(&buffer);
 	}
 
 void PIA::ClearBuffer(Buffer* buffer)
@@ -30,7 +77,6 @@ void PIA::ClearBuffer(Buffer* buffer)
 		{
 		next = b->next;
 		delete b->ip;
-		delete[] b->data;
 		delete b;
 		}
 
@@ -38,20 +84,42 @@ void PIA::ClearBuffer(Buffer* buffer)
 	buffer->size = 0;
 	}
 
-void PIA::AddToBuffer(Buffer* buffer, uint64_t seq, int len, const u_char* data, bool is_orig,
-                      const IP_Hdr* ip)
+void PIA::ResetBuffer(Buffer* buffer, State new_state)
 	{
-	u_char* tmp = nullptr;
+	ClearBuffer(buffer);
+	buffer->chunks = 0;
+	buffer->state = new_state;
+	++buffer->epoch;
+	}
 
-	if ( data )
+bool PIA::BufferLimitReached(Buffer* buffer) const
+	{
+	if ( buffer->size > zeek::detail::dpd_buffer_size ||
+	     buffer->chunks > zeek::detail::dpd_max_packets )
+		return true;
+
+	if ( zeek::detail::dpd_max_total_buffer_size > 0 &&
+	     total_buffered_bytes > static_cast<int64_t>(zeek::detail::dpd_max_total_buffer_size) )
 		{
-		tmp = new u_char[len];
-		memcpy(tmp, data, len);
+		DBG_LOG(DBG_ANALYZER, "PIA global buffer limit reached (%" PRId64 " bytes)",
+		        total_buffered_bytes);
+		global_limit_counter().Inc();
+		return true;
 		}
 
+	return false;
+	}
+
+void PIA::AddToBuffer(Buffer* buffer, uint64_t seq, int len, const u_char* data, bool is_orig,
+                      const IP_Hdr* ip)
+	{
 	DataBlock* b = new DataBlock;
 	b->ip = ip ? ip->Copy() : nullptr;
-	b->data = tmp;
+
+	if ( data )
+		b->payload = make_payload(len, data);
+
+	b->data = data ? b->payload.get() : nullptr;
 	b->is_orig = is_orig;
 	b->len = len;
 	b->seq = seq;
@@ -74,11 +142,34 @@ void PIA::AddToBuffer(Buffer* buffer, int len, const u_char* data, bool is_orig,
 	AddToBuffer(buffer, -1, len, data, is_orig, ip);
 	}
 
+void PIA::AddSharedToBuffer(Buffer* buffer, std::shared_ptr<const u_char> payload, int len,
+                            bool is_orig)
+	{
+	DataBlock* b = new DataBlock;
+	b->ip = nullptr;
+	b->data = payload.get();
+	b->payload = std::move(payload);
+	b->is_orig = is_orig;
+	b->len = len;
+	b->seq = -1;
+	b->next = nullptr;
+
+	if ( buffer->tail )
+		{
+		buffer->tail->next = b;
+		buffer->tail = b;
+		}
+	else
+		buffer->head = buffer->tail = b;
+
+	buffer->size += len;
+	}
+
 void PIA::ReplayPacketBuffer(analyzer::Analyzer* analyzer)
 	{
-	DBG_LOG(DBG_ANALYZER, "PIA replaying %" PRIu64 " total packet bytes", pkt_buffer.size);
+	DBG_LOG(DBG_ANALYZER, "PIA replaying %" PRIu64 " total packet bytes", buffer.size);
 
-	for ( DataBlock* b = pkt_buffer.head; b; b = b->next )
+	for ( DataBlock* b = buffer.head; b; b = b->next )
 		analyzer->DeliverPacket(b->len, b->data, b->is_orig, -1, b->ip, 0);
 	}
 
@@ -90,7 +181,7 @@ void PIA::PIA_Done()
 void PIA::PIA_DeliverPacket(int len, const u_char* data, bool is_orig, uint64_t seq,
                             const IP_Hdr* ip, int caplen, bool clear_state)
 	{
-	if ( pkt_buffer.state == SKIPPING )
+	if ( buffer.state == SKIPPING )
 		return;
 
 	current_packet.data = data;
@@ -98,26 +189,33 @@ void PIA::PIA_DeliverPacket(int len, const u_char* data, bool is_orig, uint64_t
 	current_packet.seq = seq;
 	current_packet.is_orig = is_orig;
 
-	State new_state = pkt_buffer.state;
+	State new_state = buffer.state;
 
-	if ( pkt_buffer.state == INIT )
+	if ( buffer.state == INIT )
 		new_state = BUFFERING;
 
-	if ( (pkt_buffer.state == BUFFERING || new_state == BUFFERING) && len > 0 )
+	if ( (buffer.state == BUFFERING || new_state == BUFFERING) && len > 0 )
 		{
-		AddToBuffer(&pkt_buffer, seq, len, data, is_orig, ip);
-		if ( pkt_buffer.size > zeek::detail::dpd_buffer_size ||
-		     ++pkt_buffer.chunks > zeek::detail::dpd_max_packets )
+		AddToBuffer(&buffer, seq, len, data, is_orig, ip);
+		++buffer.chunks;
+
+		if ( BufferLimitReached(&buffer) )
 			new_state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
 		}
 
+	// A match may switch the buffer into a different mode (see
+	// PIA_TCP::ActivateAnalyzer()), in which case the state we computed
+	// for the packet buffer no longer applies.
+	uint64_t epoch = buffer.epoch;
+
 	// FIXME: I'm not sure why it does not work with eol=true...
 	DoMatch(data, len, is_orig, true, false, false, ip);
 
 	if ( clear_state )
 		zeek::detail::RuleMatcherState::ClearMatchState(is_orig);
 
-	pkt_buffer.state = new_state;
+	if ( buffer.epoch == epoch )
+		buffer.state = new_state;
 
 	current_packet.data = nullptr;
 	}
@@ -149,7 +247,7 @@ void PIA::DoMatch(const u_char* data, int len, bool is_orig, bool bol, bool eol,
 
 void PIA_UDP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule)
 	{
-	if ( pkt_buffer.state == MATCHING_ONLY )
+	if ( buffer.state == MATCHING_ONLY )
 		{
 		DBG_LOG(DBG_ANALYZER, "analyzer found but buffer already exceeded");
 		// FIXME: This is where to check whether an analyzer
@@ -165,7 +263,7 @@ void PIA_UDP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule
 			event_mgr.Enqueue(protocol_late_match, ConnVal(), tval);
 			}
 
-		pkt_buffer.state = zeek::detail::dpd_late_match_stop ? SKIPPING : MATCHING_ONLY;
+		buffer.state = zeek::detail::dpd_late_match_stop ? SKIPPING : MATCHING_ONLY;
 		return;
 		}
 
@@ -188,9 +286,37 @@ void PIA_UDP::DeactivateAnalyzer(analyzer::Tag tag)
 
 //// TCP PIA
 
-PIA_TCP::~PIA_TCP()
+std::shared_ptr<const u_char> PIA_TCP::ReplayedPrefix::Lookup(int len, const u_char* data)
 	{
-	ClearBuffer(&stream_buffer);
+	int64_t offset = delivered;
+	delivered += len;
+
+	for ( const auto& s : segments )
+		{
+		if ( offset >= s.len )
+			{
+			offset -= s.len;
+			continue;
+			}
+
+		if ( offset + len > s.len )
+			// Spans segments, not worth the trouble.
+			return nullptr;
+
+		const u_char* p = s.payload.get() + offset;
+
+		if ( memcmp(p, data, len) != 0 )
+			{
+			// The reassembled stream doesn't line up with the
+			// packets we matched, so we can't rely on the prefix.
+			segments.clear();
+			return nullptr;
+			}
+
+		return {s.payload, p};
+		}
+
+	return nullptr;
 	}
 
 void PIA_TCP::Init()
@@ -264,52 +390,74 @@ void PIA_TCP::DeliverStream(int len, const u_char* data, bool is_orig)
 	{
 	analyzer::tcp::TCP_ApplicationAnalyzer::DeliverStream(len, data, is_orig);
 
-	if ( stream_buffer.state == SKIPPING )
-		return;
+	if ( ! stream_mode )
+		{
+		// Reassembly got turned on by somebody else.  Buffered packets
+		// are of no use anymore, start over with the stream.
+		ResetBuffer(&buffer, INIT);
+		stream_mode = true;
+		}
 
-	stream_mode = true;
+	if ( buffer.state == SKIPPING )
+		return;
 
-	State new_state = stream_buffer.state;
+	State new_state = buffer.state;
 
-	if ( stream_buffer.state == INIT )
+	if ( buffer.state == INIT )
 		{
 		// FIXME: clear payload-matching state here...
 		new_state = BUFFERING;
 		}
 
-	if ( stream_buffer.state == BUFFERING || new_state == BUFFERING )
+	std::shared_ptr<const u_char> matched;
+
+	if ( auto* prefix = replayed_prefix[is_orig] )
+		matched = prefix->Lookup(len, data);
+
+	if ( buffer.state == BUFFERING || new_state == BUFFERING )
 		{
-		AddToBuffer(&stream_buffer, len, data, is_orig);
-		if ( stream_buffer.size > zeek::detail::dpd_buffer_size ||
-		     ++stream_buffer.chunks > zeek::detail::dpd_max_packets )
+		if ( matched )
+			AddSharedToBuffer(&buffer, matched, len, is_orig);
+		else
+			AddToBuffer(&buffer, len, data, is_orig);
+
+		++buffer.chunks;
+
+		if ( BufferLimitReached(&buffer) )
 			new_state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
 		}
 
-	DoMatch(data, len, is_orig, false, false, false, nullptr);
+	if ( ! matched )
+		DoMatch(data, len, is_orig, false, false, false, nullptr);
 
-	stream_buffer.state = new_state;
+	buffer.state = new_state;
 	}
 
 void PIA_TCP::Undelivered(uint64_t seq, int len, bool is_orig)
 	{
 	analyzer::tcp::TCP_ApplicationAnalyzer::Undelivered(seq, len, is_orig);
 
-	if ( stream_buffer.state != BUFFERING )
+	if ( auto* prefix = replayed_prefix[is_orig] )
+		prefix->segments.clear();
+
+	if ( buffer.state != BUFFERING )
 		return;
 
 	// We use data=nil to mark an undelivered.
-	AddToBuffer(&stream_buffer, seq, len, nullptr, is_orig);
+	AddToBuffer(&buffer, seq, len, nullptr, is_orig);
 
-	if ( ++stream_buffer.chunks > zeek::detail::dpd_max_packets )
+	if ( ++buffer.chunks > zeek::detail::dpd_max_packets )
 		{
-		stream_buffer.state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
+		buffer.state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
 		DBG_LOG(DBG_ANALYZER, "PIA_TCP[%d] buffer chunks exceeded", GetID());
 		}
 	}
 
 void PIA_TCP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule)
 	{
-	if ( stream_buffer.state == MATCHING_ONLY )
+	// Only the stream buffer is subject to late matching; in packet
+	// mode, we still switch over with whatever we have buffered.
+	if ( stream_mode && buffer.state == MATCHING_ONLY )
 		{
 		DBG_LOG(DBG_ANALYZER, "analyzer found but buffer already exceeded");
 		// FIXME: This is where to check whether an analyzer supports
@@ -325,7 +473,7 @@ void PIA_TCP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule
 			event_mgr.Enqueue(protocol_late_match, ConnVal(), tval);
 			}
 
-		stream_buffer.state = zeek::detail::dpd_late_match_stop ? SKIPPING : MATCHING_ONLY;
+		buffer.state = zeek::detail::dpd_late_match_stop ? SKIPPING : MATCHING_ONLY;
 		return;
 		}
 
@@ -375,8 +523,7 @@ void PIA_TCP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule
 		// we have been inserted somewhere further down in the
 		// analyzer tree.  In this case, we will never have seen
 		// any input at this point (because we don't get packets).
-		assert(! pkt_buffer.head);
-		assert(! stream_buffer.head);
+		assert(! buffer.head);
 		return;
 		}
 
@@ -388,10 +535,38 @@ void PIA_TCP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule
 	auto* reass_resp = new tcp::TCP_Reassembler(this, tcp, tcp::TCP_Reassembler::Direct,
 	                                            tcp->Resp());
 
+	// Take the buffered packets out of the buffer, which the reassembled
+	// stream is going to refill.
+	Buffer packets = buffer;
+	buffer.head = buffer.tail = nullptr;
+	ResetBuffer(&buffer, INIT);
+
+	ReplayedPrefix prefix[2];
+
+	for ( DataBlock* b = packets.head; b; b = b->next )
+		{
+		auto& p = prefix[b->is_orig];
+
+		if ( ! p.contiguous )
+			continue;
+
+		if ( ! p.segments.empty() && b->seq != p.next_seq )
+			{
+			p.contiguous = false;
+			continue;
+			}
+
+		p.segments.push_back({b->payload, b->len});
+		p.next_seq = b->seq + b->len;
+		}
+
+	replayed_prefix[0] = &prefix[0];
+	replayed_prefix[1] = &prefix[1];
+
 	uint64_t orig_seq = 0;
 	uint64_t resp_seq = 0;
 
-	for ( DataBlock* b = pkt_buffer.head; b; b = b->next )
+	for ( DataBlock* b = packets.head; b; b = b->next )
 		{
 		// We don't have the TCP flags here during replay. We could
 		// funnel them through, but it's non-trivial and doesn't seem
@@ -417,7 +592,11 @@ void PIA_TCP::ActivateAnalyzer(analyzer::Tag tag, const zeek::detail::Rule* rule
 			                     current->data, analyzer::tcp::TCP_Flags(), true);
 		}
 
-	ClearBuffer(&pkt_buffer);
+	replayed_prefix[0] = replayed_prefix[1] = nullptr;
+
+	// Stream blocks reassembled from the prefix still reference the
+	// packets' payload, so this releases only what's no longer needed.
+	ClearBuffer(&packets);
 
 	ReplayStreamBuffer(a);
 	reass_orig->AckReceived(orig_seq);
@@ -436,9 +615,9 @@ void PIA_TCP::DeactivateAnalyzer(analyzer::Tag tag)
 
 void PIA_TCP::ReplayStreamBuffer(analyzer::Analyzer* analyzer)
 	{
-	DBG_LOG(DBG_ANALYZER, "PIA_TCP replaying %" PRIu64 " total stream bytes", stream_buffer.size);
+	DBG_LOG(DBG_ANALYZER, "PIA_TCP replaying %" PRIu64 " total stream bytes", buffer.size);
 
-	for ( DataBlock* b = stream_buffer.head; b; b = b->next )
+	for ( DataBlock* b = buffer.head; b; b = b->next )
 		{
 		if ( b->data )
 			analyzer->NextStream(b->len, b->data, b->is_orig);
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "zeek/RuleMatcher.h"
 #include "zeek/analyzer/Analyzer.h"
 #include "zeek/analyzer/protocol/tcp/TCP.h"
@@ -58,9 +61,15 @@ protected:
 
 	// Buffers one chunk of data.  Used both for packet payload (incl.
 	// sequence numbers for TCP) and chunks of a reassembled stream.
+	//
+	// The payload is reference-counted so that blocks referring to the
+	// same bytes (e.g., a buffered packet and the stream chunk that
+	// reassembly later produces from it) share a single copy.  A block
+	// with a null payload marks undelivered data.
 	struct DataBlock
 		{
 		IP_Hdr* ip;
+		std::shared_ptr<const u_char> payload;
 		const u_char* data;
 		bool is_orig;
 		int len;
@@ -68,6 +77,9 @@ protected:
 		DataBlock* next;
 		};
 
+	// The DPD buffer.  It holds packet payload until the PIA switches
+	// into stream mode (TCP only), and chunks of the reassembled stream
+	// afterwards; see PIA_TCP.
 	struct Buffer
 		{
 		Buffer()
@@ -75,6 +87,7 @@ protected:
 			head = tail = nullptr;
 			size = 0;
 			chunks = 0;
+			epoch = 0;
 			state = INIT;
 			}
 
@@ -82,6 +95,8 @@ protected:
 		DataBlock* tail;
 		int64_t size;
 		int64_t chunks;
+		// Incremented whenever the buffer gets reset to a new mode.
+		uint64_t epoch;
 		State state;
 		};
 
@@ -89,8 +104,22 @@ protected:
 	                 const IP_Hdr* ip = nullptr);
 	void AddToBuffer(Buffer* buffer, int len, const u_char* data, bool is_orig,
 	                 const IP_Hdr* ip = nullptr);
+
+	// Adds a block that shares already buffered payload rather than
+	// copying it.
+	void AddSharedToBuffer(Buffer* buffer, std::shared_ptr<const u_char> payload, int len,
+	                       bool is_orig);
+
 	void ClearBuffer(Buffer* buffer);
 
+	// Empties the buffer and restarts buffering in the given state.
+	void ResetBuffer(Buffer* buffer, State new_state);
+
+	// Returns true if adding more data would exceed one of the DPD
+	// buffer limits, either the per-connection ones or the global
+	// dpd_max_total_buffer_size.
+	bool BufferLimitReached(Buffer* buffer) const;
+
 	DataBlock* CurrentPacket() { return &current_packet; }
 
 	void DoMatch(const u_char* data, int len, bool is_orig, bool bol, bool eol, bool clear_state,
@@ -98,7 +127,7 @@ protected:
 
 	void SetConn(Connection* c) { conn = c; }
 
-	Buffer pkt_buffer;
+	Buffer buffer;
 
 private:
 	analyzer::Analyzer* as_analyzer;
@@ -145,8 +174,6 @@ public:
 		SetConn(conn);
 		}
 
-	~PIA_TCP() override;
-
 	void Init() override;
 
 	// The first packet for each direction of a connection is passed
@@ -184,11 +211,32 @@ protected:
 	void DeactivateAnalyzer(analyzer::Tag tag) override;
 
 private:
-	// FIXME: Not sure yet whether we need both pkt_buffer and stream_buffer.
-	// In any case, it's easier this way...
-	Buffer stream_buffer;
+	// When switching from packet mode to stream mode, we feed the
+	// buffered packets through a reassembler.  For the contiguous
+	// in-order prefix of those packets, the reassembled stream consists
+	// of exactly the bytes that we have already matched and buffered,
+	// so we neither copy nor re-match them.  This tracks that prefix
+	// for one direction while the replay is in progress.
+	struct ReplayedPrefix
+		{
+		struct Segment
+			{
+			std::shared_ptr<const u_char> payload;
+			int len;
+			};
+
+		std::vector<Segment> segments;
+		uint64_t next_seq = 0;
+		int64_t delivered = 0;
+		bool contiguous = true;
+
+		// Returns the payload of the next len stream bytes if they are
+		// identical to data already matched, or null otherwise.
+		std::shared_ptr<const u_char> Lookup(int len, const u_char* data);
+		};
 
 	bool stream_mode;
+	ReplayedPrefix* replayed_prefix[2] = {nullptr, nullptr};
 	};
 
 	} // namespace zeek::analyzer::pia
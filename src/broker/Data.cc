@@ -194,7 +194,7 @@ struct val_converter
 
 		using namespace std::chrono;
 		auto s = duration_cast<broker::fractional_seconds>(a);
-		return make_intrusive<IntervalVal>(s.count());
+		return val_mgr->Interval(s.count());
 		}
 
 	result_type operator()(broker::enum_value& a)
@@ -68,7 +68,7 @@ template <class T> static inline void set_option(const char* option, const T& va
 		{
 		using std::chrono::duration_cast;
 		auto ts = duration_cast<broker::fractional_seconds>(value);
-		id->SetVal(make_intrusive<IntervalVal>(ts.count()));
+		id->SetVal(val_mgr->Interval(ts.count()));
 		}
 	else if constexpr ( std::is_same_v<T, std::vector<std::string>> )
 		{
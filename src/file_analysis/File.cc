@@ -447,8 +447,10 @@ void File::DeliverChunk(const u_char* data, uint64_t len, uint64_t offset)
 				}
 			}
 
-		// Forward data to the reassembler.
-		file_reassembler->NewBlock(run_state::network_time, offset, len, data);
+		// Forward data to the reassembler, unless it simply continues
+		// the stream and we can hand it on without buffering a copy.
+		if ( ! file_reassembler->DeliverInOrder(offset, len, data) )
+			file_reassembler->NewBlock(run_state::network_time, offset, len, data);
 		}
 	else if ( stream_offset == offset )
 		{
@@ -43,6 +43,20 @@ uint64_t FileReassembler::FlushTo(uint64_t sequence)
 	return rval;
 	}
 
+bool FileReassembler::DeliverInOrder(uint64_t seq, uint64_t len, const u_char* data)
+	{
+	if ( flushing || seq != last_reassem_seq || ! block_list.Empty() )
+		return false;
+
+	last_reassem_seq += len;
+	the_file->DeliverStream(data, len);
+
+	// Moves the trim point along so that retransmissions of this data
+	// are recognized as old.
+	TrimToSeq(last_reassem_seq);
+	return true;
+	}
+
 void FileReassembler::BlockInserted(DataBlockMap::const_iterator it)
 	{
 	const auto& start_block = it->second;
@@ -50,6 +50,18 @@ public:
 	 */
 	bool IsCurrentlyFlushing() const { return flushing; }
 
+	/**
+	 * Passes a block straight on to File::DeliverStream() without copying
+	 * it into the reassembly buffer, provided it continues the file at the
+	 * current reassembly point and nothing else is buffered.
+	 * @param seq the file offset of the block.
+	 * @param len the length of the block.
+	 * @param data pointer to the block's data.
+	 * @return true if the block was delivered, false if it needs to go
+	 * through NewBlock() instead.
+	 */
+	bool DeliverInOrder(uint64_t seq, uint64_t len, const u_char* data);
+
 protected:
 	void Undelivered(uint64_t up_to_seq) override;
 	void BlockInserted(DataBlockMap::const_iterator it) override;
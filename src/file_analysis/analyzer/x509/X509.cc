@@ -339,6 +339,9 @@ void X509::ParseSAN(X509_EXTENSION* ext)
 		return;
 		}
 
+	// Without a handler, we still go through the names for their weirds.
+	bool build = static_cast<bool>(x509_ext_subject_alternative_name);
+
 	VectorValPtr names;
 	VectorValPtr emails;
 	VectorValPtr uris;
@@ -359,6 +362,9 @@ void X509::ParseSAN(X509_EXTENSION* ext)
 				continue;
 				}
 
+			if ( ! build )
+				continue;
+
 			auto len = ASN1_STRING_length(gen->d.ia5);
 #if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
 			const char* name = (const char*)ASN1_STRING_data(gen->d.ia5);
@@ -394,23 +400,25 @@ void X509::ParseSAN(X509_EXTENSION* ext)
 
 		else if ( gen->type == GEN_IPADD )
 			{
-			if ( ips == nullptr )
+			if ( ips == nullptr && build )
 				ips = make_intrusive<VectorVal>(id::find_type<VectorType>("addr_vec"));
 
 			uint32_t* addr = (uint32_t*)gen->d.ip->data;
 
-			if ( gen->d.ip->length == 4 )
-				ips->Assign(ips->Size(), make_intrusive<AddrVal>(*addr));
-
-			else if ( gen->d.ip->length == 16 )
-				ips->Assign(ips->Size(), make_intrusive<AddrVal>(addr));
-
-			else
+			if ( gen->d.ip->length != 4 && gen->d.ip->length != 16 )
 				{
 				reporter->Weird(GetFile(), "x509_san_ip_length",
 				                util::fmt("%d", gen->d.ip->length));
 				continue;
 				}
+
+			if ( ! build )
+				continue;
+
+			if ( gen->d.ip->length == 4 )
+				ips->Assign(ips->Size(), make_intrusive<AddrVal>(*addr));
+			else
+				ips->Assign(ips->Size(), make_intrusive<AddrVal>(addr));
 			}
 
 		else
@@ -422,6 +430,12 @@ void X509::ParseSAN(X509_EXTENSION* ext)
 			}
 		}
 
+	if ( ! build )
+		{
+		GENERAL_NAMES_free(altname);
+		return;
+		}
+
 	auto sanExt = make_intrusive<RecordVal>(BifType::Record::X509::SubjectAlternativeName);
 
 	if ( names != nullptr )
@@ -2,8 +2,10 @@
 
 #include "zeek/packet_analysis/Analyzer.h"
 
+#include "zeek/AnalyzerStats.h"
 #include "zeek/DebugLogger.h"
 #include "zeek/Dict.h"
+#include "zeek/NetVar.h"
 #include "zeek/RunState.h"
 #include "zeek/session/Manager.h"
 #include "zeek/util.h"
@@ -73,6 +75,27 @@ AnalyzerPtr Analyzer::Lookup(uint32_t identifier) const
 	return dispatcher.Lookup(identifier);
 	}
 
+zeek::detail::AnalyzerStats* Analyzer::Stats()
+	{
+	if ( ! zeek::detail::analyzer_profiling )
+		return nullptr;
+
+	if ( ! stats )
+		stats = zeek::detail::AnalyzerStats::Lookup("packet", GetAnalyzerName());
+
+	return stats;
+	}
+
+bool Analyzer::Dispatch(const AnalyzerPtr& analyzer, size_t len, const uint8_t* data,
+                        Packet* packet)
+	{
+	if ( ! zeek::detail::analyzer_profiling )
+		return analyzer->AnalyzePacket(len, data, packet);
+
+	zeek::detail::AnalyzerStatsScope profile(analyzer->Stats(), len);
+	return analyzer->AnalyzePacket(len, data, packet);
+	}
+
 bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet,
                              uint32_t identifier) const
 	{
@@ -96,13 +119,13 @@ bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet,
 
 	DBG_LOG(DBG_PACKET_ANALYSIS, "Analysis in %s succeeded, next layer identifier is %#x.",
 	        GetAnalyzerName(), identifier);
-	return inner_analyzer->AnalyzePacket(len, data, packet);
+	return Dispatch(inner_analyzer, len, data, packet);
 	}
 
 bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet) const
 	{
 	if ( default_analyzer )
-		return default_analyzer->AnalyzePacket(len, data, packet);
+		return Dispatch(default_analyzer, len, data, packet);
 
 	DBG_LOG(DBG_PACKET_ANALYSIS, "Analysis in %s stopped, no default analyzer available.",
 	        GetAnalyzerName());
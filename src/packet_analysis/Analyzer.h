@@ -5,6 +5,11 @@
 #include "zeek/packet_analysis/Manager.h"
 #include "zeek/packet_analysis/Tag.h"
 
+namespace zeek::detail
+	{
+class AnalyzerStats;
+	}
+
 namespace zeek::packet_analysis
 	{
 
@@ -68,6 +73,12 @@ public:
 	 */
 	bool IsAnalyzer(const char* name);
 
+	/**
+	 * Returns the analyzer_profiling metrics for this analyzer, creating
+	 * them on first use, or null if profiling is off.
+	 */
+	zeek::detail::AnalyzerStats* Stats();
+
 	/**
 	 * Analyzes the given packet. A common case is that the analyzed protocol
 	 * encapsulates another protocol, which can be determined by an identifier
@@ -165,10 +176,20 @@ protected:
 	void Weird(const char* name, Packet* packet = nullptr, const char* addl = "") const;
 
 private:
+	// Hands the packet to the given analyzer, accounting for it if
+	// analyzer_profiling is on.
+	static bool Dispatch(const AnalyzerPtr& analyzer, size_t len, const uint8_t* data,
+	                     Packet* packet);
+
 	Tag tag;
 	Dispatcher dispatcher;
 	AnalyzerPtr default_analyzer = nullptr;
 
+	/**
+	 * Metrics for analyzer_profiling, created on first use.
+	 */
+	zeek::detail::AnalyzerStats* stats = nullptr;
+
 	/**
 	 * Flag for whether to report unknown protocols in ForwardPacket.
 	 */
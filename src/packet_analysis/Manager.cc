@@ -2,6 +2,7 @@
 
 #include "zeek/packet_analysis/Manager.h"
 
+#include "zeek/AnalyzerStats.h"
 #include "zeek/RunState.h"
 #include "zeek/Stats.h"
 #include "zeek/iosource/PktDumper.h"
@@ -104,7 +105,7 @@ void Manager::ProcessPacket(Packet* packet)
 		}
 
 	// Start packet analysis
-	root_analyzer->ForwardPacket(packet->cap_len, packet->data, packet, packet->link_type);
+	ForwardToRoot(packet);
 
 	if ( raw_packet )
 		event_mgr.Enqueue(raw_packet, packet->ToRawPktHdrVal());
@@ -116,6 +117,14 @@ void Manager::ProcessPacket(Packet* packet)
 
 bool Manager::ProcessInnerPacket(Packet* packet)
 	{
+	return ForwardToRoot(packet);
+	}
+
+bool Manager::ForwardToRoot(Packet* packet)
+	{
+	// The root analyzer doesn't get its packets through another analyzer's
+	// ForwardPacket(), so it needs accounting of its own.
+	zeek::detail::AnalyzerStatsScope profile(root_analyzer->Stats(), packet->cap_len);
 	return root_analyzer->ForwardPacket(packet->cap_len, packet->data, packet, packet->link_type);
 	}
 
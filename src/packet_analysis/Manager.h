@@ -149,6 +149,12 @@ private:
 
 	bool PermitUnknownProtocol(const std::string& analyzer, uint32_t protocol);
 
+	/**
+	 * Hands a packet to the root analyzer, accounting for it if
+	 * analyzer_profiling is on.
+	 */
+	bool ForwardToRoot(Packet* packet);
+
 	std::map<std::string, AnalyzerPtr> analyzers;
 	AnalyzerPtr root_analyzer = nullptr;
 
@@ -495,9 +495,9 @@ void ICMPAnalyzer::RouterAdvert(double t, const struct icmp* icmpp, int len, int
 		val_mgr->Count((icmpp->icmp_wpa & 0x18) >> 3), // Pref
 		val_mgr->Bool(icmpp->icmp_wpa & 0x04), // Proxy
 		val_mgr->Count(icmpp->icmp_wpa & 0x02), // Reserved
-		make_intrusive<IntervalVal>((double)ntohs(icmpp->icmp_lifetime), Seconds),
-		make_intrusive<IntervalVal>((double)ntohl(reachable), Milliseconds),
-		make_intrusive<IntervalVal>((double)ntohl(retrans), Milliseconds),
+		val_mgr->Interval(ntohs(icmpp->icmp_lifetime)),
+		val_mgr->Interval(ntohl(reachable) * Milliseconds),
+		val_mgr->Interval(ntohl(retrans) * Milliseconds),
 		BuildNDOptionsVal(caplen - opt_offset, data + opt_offset, adapter));
 	}
 
@@ -709,10 +709,8 @@ zeek::VectorValPtr ICMPAnalyzer::BuildNDOptionsVal(int caplen, const u_char* dat
 						info->Assign(0, val_mgr->Count(prefix_len));
 						info->Assign(1, val_mgr->Bool(L_flag));
 						info->Assign(2, val_mgr->Bool(A_flag));
-						info->Assign(
-							3, make_intrusive<IntervalVal>((double)ntohl(valid_life), Seconds));
-						info->Assign(
-							4, make_intrusive<IntervalVal>((double)ntohl(prefer_life), Seconds));
+						info->Assign(3, val_mgr->Interval(ntohl(valid_life)));
+						info->Assign(4, val_mgr->Interval(ntohl(prefer_life)));
 						info->Assign(5, make_intrusive<AddrVal>(IPAddr(prefix)));
 						rv->Assign(3, std::move(info));
 						}
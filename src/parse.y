@@ -28,7 +28,7 @@
 %token TOK_ATTR_BROKER_STORE_ALLOW_COMPLEX TOK_ATTR_BACKEND
 %token TOK_ATTR_PRIORITY TOK_ATTR_LOG TOK_ATTR_ERROR_HANDLER
 %token TOK_ATTR_TYPE_COLUMN TOK_ATTR_DEPRECATED
-%token TOK_ATTR_IS_ASSIGNED TOK_ATTR_IS_USED
+%token TOK_ATTR_IS_ASSIGNED TOK_ATTR_IS_USED TOK_ATTR_FAST_HASH
 
 %token TOK_DEBUG
 
@@ -808,7 +808,7 @@ expr:
 			if ( $4 )
 				re->MakeCaseInsensitive();
 
-			re->Compile();
+			re->Compile(true);
 			$$ = new ConstExpr(make_intrusive<PatternVal>(re));
 			}
 
@@ -1503,6 +1503,8 @@ attr:
 			{ $$ = new Attr(ATTR_IS_ASSIGNED); }
 	|	TOK_ATTR_IS_USED
 			{ $$ = new Attr(ATTR_IS_USED); }
+	|	TOK_ATTR_FAST_HASH
+			{ $$ = new Attr(ATTR_FAST_HASH); }
 	|	TOK_ATTR_ADD_FUNC '=' expr
 			{ $$ = new Attr(ATTR_ADD_FUNC, {AdoptRef{}, $3}); }
 	|	TOK_ATTR_DEL_FUNC '=' expr
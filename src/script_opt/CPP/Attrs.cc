@@ -191,6 +191,8 @@ const char* CPPCompile::AttrName(const AttrPtr& attr)
 			return "ATTR_IS_ASSIGNED";
 		case ATTR_IS_USED:
 			return "ATTR_IS_USED";
+		case ATTR_FAST_HASH:
+			return "ATTR_FAST_HASH";
 
 		default:
 			return "<busted>";
@@ -462,7 +462,7 @@ ValPtr Expr::MakeZero(TypeTag t) const
 		case TYPE_TIME:
 			return make_intrusive<TimeVal>(0.0);
 		case TYPE_INTERVAL:
-			return make_intrusive<IntervalVal>(0.0, 1.0);
+			return val_mgr->Interval(0.0);
 
 		default:
 			reporter->InternalError("bad call to MakeZero");
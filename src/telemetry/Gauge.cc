@@ -82,6 +82,11 @@ void DblGauge::Dec(double amount) noexcept
 	deref(pimpl).dec(amount);
 	}
 
+void DblGauge::Set(double value) noexcept
+	{
+	deref(pimpl).value(value);
+	}
+
 double DblGauge::Value() const noexcept
 	{
 	return deref(pimpl).value();
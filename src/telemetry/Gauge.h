@@ -170,6 +170,11 @@ public:
 	 */
 	void Dec(double amount) noexcept;
 
+	/**
+	 * Sets the value to @p value.
+	 */
+	void Set(double value) noexcept;
+
 	/**
 	 * @return The current value.
 	 */
@@ -39,8 +39,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "zeek/3rdparty/doctest.h"
@@ -290,6 +292,32 @@ bool ensure_intermediate_dirs(const char* dirname)
 	return true;
 	}
 
+void parallel_for(size_t n, size_t num_threads, const std::function<void(size_t)>& f)
+	{
+	if ( num_threads == 0 )
+		num_threads = std::thread::hardware_concurrency();
+
+	num_threads = std::max(size_t(1), std::min(num_threads, n));
+
+	std::atomic<size_t> next = 0;
+
+	auto run = [&]()
+	{
+		for ( size_t i = next++; i < n; i = next++ )
+			f(i);
+	};
+
+	std::vector<std::thread> threads;
+
+	for ( size_t i = 1; i < num_threads; ++i )
+		threads.emplace_back(run);
+
+	run();
+
+	for ( auto& t : threads )
+		t.join();
+	}
+
 bool ensure_dir(const char* dirname)
 	{
 	if ( mkdir(dirname, 0777) == 0 )
@@ -22,6 +22,7 @@
 #include <array>
 #include <cinttypes>
 #include <cstdint>
+#include <functional>
 #include <memory> // std::unique_ptr
 #include <string>
 #include <string_view>
@@ -109,6 +110,11 @@ extern const char* fmt_access_time(double time);
 extern bool ensure_intermediate_dirs(const char* dirname);
 extern bool ensure_dir(const char* dirname);
 
+// Calls f(i) for each i in [0, n), spreading the calls across up to
+// num_threads threads including the calling one. Zero means one thread
+// per core.
+extern void parallel_for(size_t n, size_t num_threads, const std::function<void(size_t)>& f);
+
 extern void hmac_md5(size_t size, const unsigned char* bytes, unsigned char digest[16]);
 
 // Initializes RNGs for zeek::random_number() and MD5 usage.  If load_file is given,
@@ -4,6 +4,7 @@
 
 #include "zeek/zeek-config.h"
 
+#include <errno.h>
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #include <signal.h>
@@ -131,6 +132,7 @@ zeek::OpaqueTypePtr bloomfilter_type;
 zeek::OpaqueTypePtr x509_opaque_type;
 zeek::OpaqueTypePtr ocsp_resp_opaque_type;
 zeek::OpaqueTypePtr paraglob_type;
+zeek::OpaqueTypePtr pattern_set_type;
 zeek::OpaqueTypePtr int_counter_metric_type;
 zeek::OpaqueTypePtr int_counter_metric_family_type;
 zeek::OpaqueTypePtr dbl_counter_metric_type;
@@ -338,6 +340,7 @@ static void terminate_bro()
 	delete session_mgr;
 	delete fragment_mgr;
 	delete telemetry_mgr;
+	telemetry_mgr = nullptr;
 
 	// free the global scope
 	pop_scope();
@@ -366,6 +369,30 @@ static void bro_new_handler()
 	out_of_memory("new");
 	}
 
+// Returns the value of an environment variable setting the size of one of
+// the ValManager's caches, or the default if it's not set.
+template <typename T> static T val_cache_limit(const char* env, T dflt, T min, T max)
+	{
+	auto s = getenv(env);
+
+	if ( ! s )
+		return dflt;
+
+	char* end;
+	errno = 0;
+	auto v = strtoll(s, &end, 10);
+
+	if ( errno || *end || end == s || v < static_cast<long long>(min) ||
+	     v > static_cast<long long>(max) )
+		{
+		fprintf(stderr, "invalid value for %s: '%s' (must be between %lld and %lld)\n", env, s,
+		        static_cast<long long>(min), static_cast<long long>(max));
+		exit(1);
+		}
+
+	return static_cast<T>(v);
+	}
+
 static std::vector<std::string> get_script_signature_files()
 	{
 	std::vector<std::string> rval;
@@ -474,7 +501,17 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 
 	run_state::zeek_start_time = util::current_time(true);
 
-	val_mgr = new ValManager();
+	// The largest values the ValManager preallocates are tunable, since
+	// what values are common depends on the scripts and traffic.
+	constexpr auto max_cached = 1 << 24;
+	auto max_count = val_cache_limit<bro_uint_t>("ZEEK_VAL_CACHE_MAX_COUNT",
+	                                             ValManager::PREALLOCATED_COUNTS - 1, 0,
+	                                             max_cached);
+	auto max_int = val_cache_limit<bro_int_t>("ZEEK_VAL_CACHE_MAX_INT",
+	                                          ValManager::PREALLOCATED_INT_HIGHEST,
+	                                          ValManager::PREALLOCATED_INT_LOWEST, max_cached);
+
+	val_mgr = new ValManager(max_count, max_int);
 	reporter = new Reporter(options.abort_on_scripting_errors);
 	thread_mgr = new threading::Manager();
 	plugin_mgr = new plugin::Manager();
@@ -617,6 +654,7 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 	x509_opaque_type = make_intrusive<OpaqueType>("x509");
 	ocsp_resp_opaque_type = make_intrusive<OpaqueType>("ocsp_resp");
 	paraglob_type = make_intrusive<OpaqueType>("paraglob");
+	pattern_set_type = make_intrusive<OpaqueType>("pattern_set");
 	int_counter_metric_type = make_intrusive<OpaqueType>("int_counter_metric");
 	int_counter_metric_family_type = make_intrusive<OpaqueType>("int_counter_metric_family");
 	dbl_counter_metric_type = make_intrusive<OpaqueType>("dbl_counter_metric");
@@ -652,10 +690,16 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 		};
 		auto ipbb = make_intrusive<BuiltinFunc>(init_bifs, ipbid->Name(), false);
 
+		double time_parse_start = util::current_time(true);
+
 		run_state::is_parsing = true;
 		yyparse();
 		run_state::is_parsing = false;
 
+		if ( options.print_execution_time )
+			fprintf(stderr, "# script parsing %.6f\n",
+			        util::current_time(true) - time_parse_start);
+
 		RecordVal::DoneParsing();
 		TableVal::DoneParsing();
 
@@ -663,6 +707,14 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 		init_net_var();
 		run_bif_initializers();
 
+		// The parser left building the DFAs of pattern constants to us.
+		double time_patterns_start = util::current_time(true);
+		build_pending_dfas(pattern_compile_threads);
+
+		if ( options.print_execution_time )
+			fprintf(stderr, "# script patterns %.6f\n",
+			        util::current_time(true) - time_patterns_start);
+
 		// Assign the script_args for command line processing in Zeek scripts.
 		if ( ! options.script_args.empty() )
 			{
@@ -759,6 +811,14 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 			if ( options.print_signature_debug_info )
 				rule_matcher->PrintDebug();
 
+			if ( options.print_execution_time )
+				{
+				const auto& t = rule_matcher->GetSetupTimes();
+				fprintf(stderr,
+				        "# signatures %.6f (parse %.6f, tree %.6f, regex %.6f, dfa %.6f)\n",
+				        t.parse + t.tree + t.regex + t.dfa, t.parse, t.tree, t.regex, t.dfa);
+				}
+
 			file_mgr->InitMagic();
 			}
 